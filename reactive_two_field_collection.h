@@ -13,9 +13,15 @@
 //==============================================================================
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cmath>
+#include <thread>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 #include <unordered_map>
@@ -23,11 +29,15 @@
 #include <optional>
 #include <mutex>
 #include <shared_mutex>
+#include <span>
 #include <map>
+#include <memory_resource>
 #include <set>
 #include <memory>
 #include <limits>
+#include <exception>
 #include <functional>
+#include <initializer_list>
 #include <stdexcept>
 #include <unordered_set>
 #include <reaction/reaction.h>
@@ -39,7 +49,10 @@ namespace reactive {
 // FORWARD DECLARATIONS & ENUMS
 //==============================================================================
 
-enum class AggMode { Add, Min, Max };
+// Add folds deltas; every other mode aggregates the extractor's value per element: Min / Max
+// (ordered index), Count (element count), Mean and Variance (population, Welford), Range
+// (max - min) and Quantile (order statistics; the median unless configured).
+enum class AggMode { Add, Min, Max, Count, Mean, Variance, Range, Quantile };
 
 //==============================================================================
 // DETAIL NAMESPACE - HELPER FUNCTORS & UTILITIES
@@ -137,6 +150,581 @@ struct DefaultApplyAdd {
     }
 };
 
+// Add totals applied with DefaultApplyAdd to an arithmetic type are accumulated in a std::atomic;
+// custom apply functors keep the Var-backed path.
+template <AggMode Mode, typename TotalT, typename DeltaT, typename ApplyFn>
+inline constexpr bool atomic_add_total_v =
+    Mode == AggMode::Add && std::is_arithmetic_v<TotalT> && !std::is_same_v<std::remove_cv_t<TotalT>, bool> &&
+    std::is_same_v<std::remove_cv_t<std::remove_reference_t<ApplyFn>>, DefaultApplyAdd<TotalT, DeltaT>>;
+
+// Apply functors opt into lock-free application with `static constexpr bool lock_free_apply = true`:
+// operator() must be const, free of side effects and safe to re-run, because the collection calls it
+// concurrently inside a CAS loop on an atomic total.
+template <typename ApplyFn, typename = void>
+struct has_lock_free_apply : std::false_type {};
+template <typename ApplyFn>
+struct has_lock_free_apply<ApplyFn, std::void_t<decltype(ApplyFn::lock_free_apply)>>
+    : std::bool_constant<ApplyFn::lock_free_apply> {};
+
+template <AggMode Mode, typename TotalT, typename DeltaT, typename ApplyFn>
+inline constexpr bool cas_apply_total_v =
+    Mode == AggMode::Add && std::is_arithmetic_v<TotalT> && !std::is_same_v<std::remove_cv_t<TotalT>, bool> &&
+    has_lock_free_apply<std::remove_cv_t<std::remove_reference_t<ApplyFn>>>::value &&
+    !atomic_add_total_v<Mode, TotalT, DeltaT, ApplyFn>;
+
+// DefaultApplyAdd on an atomic total; returns the new value. Integers use fetch_add (which wraps
+// like wrapping_add), floating point a CAS loop. Sequentially consistent so TotalPublisher's
+// flag protocol also orders the accumulation.
+template <typename TotalT, typename DeltaT>
+TotalT atomic_add_total(std::atomic<TotalT> &total, const DeltaT &d) noexcept {
+    const TotalT step = bounded_numeric_cast<TotalT>(d);
+    if constexpr (std::is_integral_v<TotalT>) {
+        return wrapping_add(total.fetch_add(step), step);
+    } else {
+        TotalT cur = total.load();
+        TotalT next = wrapping_add(cur, step);
+        while (!total.compare_exchange_weak(cur, next)) {
+            next = wrapping_add(cur, step);
+        }
+        return next;
+    }
+}
+
+// Sum of Add contributions rebuilt by recompute_totals(): DefaultApplyAdd for integral and
+// user-defined totals, Neumaier-compensated for floating point so the rebuilt total does not
+// pick up a drift of its own.
+template <typename T>
+struct RecomputeSum {
+    T sum{};
+    T compensation{};
+
+    template <typename D>
+    void add(const D &d) {
+        if constexpr (std::is_floating_point_v<T>) {
+            const T x = bounded_numeric_cast<T>(d);
+            const T t = sum + x;
+            compensation += std::abs(sum) >= std::abs(x) ? (sum - t) + x : (x - t) + sum;
+            sum = t;
+        } else {
+            DefaultApplyAdd<T, D>{}(sum, d);
+        }
+    }
+    void merge(const RecomputeSum &other) {
+        add(other.sum);
+        if constexpr (std::is_floating_point_v<T>) add(other.compensation);
+    }
+    T value() const {
+        if constexpr (std::is_floating_point_v<T>) return sum + compensation;
+        else return sum;
+    }
+};
+
+// Storage of an AtomicAccumulator total: one std::atomic.
+template <typename T>
+class AtomicTotal {
+public:
+    template <typename D>
+    void add(const D &d) noexcept { atomic_add_total(value_, d); }
+    T load() const noexcept { return value_.load(); }
+    void store(const T &v) noexcept { value_.store(v); }
+
+    // Runs a lock_free_apply functor on a copy of the total and installs the result by CAS,
+    // retrying on interference; returns false (storing nothing) when fn reports no change.
+    template <typename Fn, typename D>
+    bool apply(const Fn &fn, const D &d) {
+        T cur = value_.load();
+        T next;
+        do {
+            next = cur;
+            if (!fn(next, d)) return false;
+        } while (!value_.compare_exchange_weak(cur, next));
+        return true;
+    }
+
+private:
+    std::atomic<T> value_{};
+};
+
+// Per-thread slot number, handed out round-robin on a thread's first accumulation.
+inline std::size_t thread_shard_slot() noexcept {
+    static std::atomic<std::size_t> next_slot{0};
+    thread_local const std::size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+// Storage of a ShardedAccumulator total: cache-line-padded partial sums, one per thread slot
+// (modulo Shards); load() folds them. Floating-point folds may round differently from a single
+// running sum.
+template <typename T, std::size_t Shards>
+class ShardedTotal {
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "ShardedAccumulator shard count must be a power of two");
+
+public:
+    template <typename D>
+    void add(const D &d) noexcept { atomic_add_total(shards_[thread_shard_slot() & (Shards - 1)].value, d); }
+    T load() const noexcept {
+        T sum{};
+        for (const auto &shard : shards_) sum = wrapping_add(sum, shard.value.load());
+        return sum;
+    }
+    // Not atomic with respect to add(); callers keep writers out while replacing the total.
+    void store(const T &v) noexcept {
+        shards_[0].value.store(v);
+        for (std::size_t i = 1; i < Shards; ++i) shards_[i].value.store(T{});
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<T> value{};
+    };
+    std::array<Shard, Shards> shards_{};
+};
+
+// Copies an accumulated total into its reaction::Var without making writers wait on each other:
+// the writer that claims busy_ publishes until no change is pending, the others only mark dirty_
+// (a plain load when it is already set, so a hot total does not bounce the flag's cache line).
+// seq_cst throughout keeps a losing writer's change visible to the publisher's final check.
+class TotalPublisher {
+public:
+    // load() returns the current authoritative value.
+    template <typename Load, typename T>
+    void publish(const Load &load, reaction::Var<T> &dst) {
+        run([&] { dst.value(load()); });
+    }
+    // As publish(), but leaves dst (and its observers) alone while the value is unchanged.
+    template <typename Load, typename T>
+    void publish_changes(const Load &load, reaction::Var<T> &dst) {
+        run([&] {
+            T v = load();
+            if (!(dst.get() == v)) dst.value(std::move(v));
+        });
+    }
+
+private:
+    template <typename Write>
+    void run(const Write &write) {
+        if (!dirty_.load()) dirty_.store(true);
+        while (dirty_.load()) {
+            if (busy_.load()) return;
+            bool expected = false;
+            if (!busy_.compare_exchange_strong(expected, true)) return;
+            while (dirty_.exchange(false)) write();
+            busy_.store(false);
+        }
+    }
+
+    std::atomic<bool> dirty_{false};
+    std::atomic<bool> busy_{false};
+};
+
+// Concurrent multiset extremum for Min/Max totals, keyed by (value, element id) so the holder of
+// the extremum is known. Entries hash by id to one of Shards count maps, each under its own mutex
+// with tree nodes recycled from a per-shard pool, and each shard caches its best entry (behind a
+// sequence counter for arithmetic values, so readers never lock); top_entry() folds the caches.
+// Ties go to the smallest id. Counts are signed so an element's erase may land before the insert
+// it undoes (updates of one element applied out of order still net out), and only positive
+// counts contribute.
+template <typename T, AggMode Mode, std::size_t Shards = 16, typename Id = std::size_t>
+class ShardedExtremumIndex {
+    static_assert(Mode == AggMode::Min || Mode == AggMode::Max, "ShardedExtremumIndex tracks Min or Max");
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "shard count must be a power of two");
+
+public:
+    using entry_type = std::pair<T, Id>;
+
+    void insert(const T &v, Id id = Id{}) { adjust(v, id, 1); }
+    void erase_one(const T &v, Id id = Id{}) { adjust(v, id, -1); }
+
+    std::optional<entry_type> top_entry() const {
+        std::optional<entry_type> best;
+        for (const auto &shard : shards_) {
+            auto candidate = read_cache(shard);
+            if (candidate && (!best || KeyLess{}(*candidate, *best))) best = std::move(candidate);
+        }
+        return best;
+    }
+    std::optional<T> top() const {
+        auto entry = top_entry();
+        if (!entry) return std::nullopt;
+        return entry->first;
+    }
+    // The extremum, or T{} when nothing is tracked.
+    T load() const {
+        auto t = top();
+        return t ? *t : T{};
+    }
+
+private:
+    static constexpr bool cache_is_atomic = std::is_arithmetic_v<T>;
+
+    // Best entry first: extremum value, then smallest id.
+    struct KeyLess {
+        bool operator()(const entry_type &a, const entry_type &b) const {
+            if constexpr (Mode == AggMode::Min) {
+                if (a.first < b.first) return true;
+                if (b.first < a.first) return false;
+            } else {
+                if (b.first < a.first) return true;
+                if (a.first < b.first) return false;
+            }
+            return a.second < b.second;
+        }
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mtx;
+        std::pmr::unsynchronized_pool_resource pool;
+        std::pmr::map<entry_type, std::ptrdiff_t, KeyLess> counts{&pool};
+        std::atomic<std::uint64_t> seq{0};  // odd while refresh() rewrites the cache
+        std::atomic<bool> has{false};
+        std::conditional_t<cache_is_atomic, std::atomic<T>, T> best{};
+        std::atomic<Id> best_id{};
+    };
+
+    static std::size_t shard_of(const Id &id) {
+        // Mixed in 64 bits whatever the width of size_t (wasm32 included).
+        const std::uint64_t h = static_cast<std::uint64_t>(id) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(h >> 32) & (Shards - 1);
+    }
+
+    void adjust(const T &v, const Id &id, std::ptrdiff_t by) {
+        Shard &shard = shards_[shard_of(id)];
+        std::lock_guard<std::mutex> g(shard.mtx);
+        auto [it, inserted] = shard.counts.try_emplace(entry_type{v, id}, 0);
+        (void)inserted;
+        it->second += by;
+        if (it->second == 0) shard.counts.erase(it);
+        refresh(shard);
+    }
+
+    // Caller holds shard.mtx.
+    static void refresh(Shard &shard) {
+        auto first = shard.counts.begin();
+        while (first != shard.counts.end() && first->second <= 0) ++first;
+        // Release stores publish the odd sequence before any cache field; a reader that sees a new
+        // field therefore sees the sequence move.
+        const std::uint64_t seq = shard.seq.load(std::memory_order_relaxed);
+        shard.seq.store(seq + 1, std::memory_order_relaxed);
+        if (first != shard.counts.end()) {
+            if constexpr (cache_is_atomic) shard.best.store(first->first.first, std::memory_order_release);
+            else shard.best = first->first.first;
+            shard.best_id.store(first->first.second, std::memory_order_release);
+            shard.has.store(true, std::memory_order_release);
+        } else {
+            shard.has.store(false, std::memory_order_release);
+        }
+        shard.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    static std::optional<entry_type> read_cache(const Shard &shard) {
+        if constexpr (cache_is_atomic) {
+            for (;;) {
+                const std::uint64_t before = shard.seq.load(std::memory_order_acquire);
+                if (before & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const bool has = shard.has.load(std::memory_order_acquire);
+                const T value = shard.best.load(std::memory_order_acquire);
+                const Id id = shard.best_id.load(std::memory_order_acquire);
+                if (shard.seq.load(std::memory_order_relaxed) != before) continue;
+                if (!has) return std::nullopt;
+                return entry_type{value, id};
+            }
+        } else {
+            std::lock_guard<std::mutex> g(shard.mtx);
+            if (!shard.has.load(std::memory_order_relaxed)) return std::nullopt;
+            return entry_type{shard.best, shard.best_id.load(std::memory_order_relaxed)};
+        }
+    }
+
+    std::array<Shard, Shards> shards_{};
+};
+
+// Element count for AggMode::Count; the extracted value is ignored.
+template <typename T, typename Id = std::size_t>
+class CountTracker {
+public:
+    template <typename V>
+    void insert(const V &, Id = Id{}) { n_.fetch_add(1); }
+    template <typename V>
+    void erase_one(const V &, Id = Id{}) { n_.fetch_sub(1); }
+    T load() const { return bounded_numeric_cast<T>(n_.load()); }
+
+private:
+    std::atomic<long long> n_{0};
+};
+
+// Moments of a batch of values, mergeable across workers (Chan et al.); recompute_totals()
+// builds one per scan worker and installs the merged result with MomentTracker::assign().
+template <typename T>
+struct Moments {
+    long long n = 0;
+    long double mean = 0;
+    long double m2 = 0;
+
+    void add(const T &v) {
+        const long double x = static_cast<long double>(v);
+        ++n;
+        const long double delta = x - mean;
+        mean += delta / static_cast<long double>(n);
+        m2 += delta * (x - mean);
+    }
+    void merge(const Moments &other) {
+        if (other.n == 0) return;
+        if (n == 0) {
+            *this = other;
+            return;
+        }
+        const long double na = static_cast<long double>(n);
+        const long double nb = static_cast<long double>(other.n);
+        const long double delta = other.mean - mean;
+        n += other.n;
+        mean += delta * nb / static_cast<long double>(n);
+        m2 += other.m2 + delta * delta * na * nb / static_cast<long double>(n);
+    }
+};
+
+// Running mean and population variance for AggMode::Mean / AggMode::Variance. Welford's update
+// with a signed weight: +1 adds a value and -1 is its exact inverse, so removal is O(1) and an
+// element's erase may land before the insert it undoes, as with ShardedExtremumIndex's counts.
+template <typename T, AggMode Mode, typename Id = std::size_t>
+class MomentTracker {
+    static_assert(Mode == AggMode::Mean || Mode == AggMode::Variance, "MomentTracker tracks Mean or Variance");
+
+public:
+    void insert(const T &v, Id = Id{}) { adjust(static_cast<long double>(v), 1); }
+    void erase_one(const T &v, Id = Id{}) { adjust(static_cast<long double>(v), -1); }
+
+    void assign(const Moments<T> &m) {
+        std::lock_guard<std::mutex> g(mtx_);
+        n_ = m.n;
+        mean_ = m.mean;
+        m2_ = m.m2;
+        zero_sum_ = zero_sum_sq_ = 0;
+    }
+
+    // The mean or population variance, or T{} when nothing is tracked.
+    T load() const {
+        std::lock_guard<std::mutex> g(mtx_);
+        if (n_ <= 0) return T{};
+        if constexpr (Mode == AggMode::Mean) return bounded_numeric_cast<T>(mean_);
+        else return bounded_numeric_cast<T>(m2_ > 0 ? m2_ / static_cast<long double>(n_) : 0.0L);
+    }
+
+private:
+    void adjust(long double x, long long w) {
+        std::lock_guard<std::mutex> g(mtx_);
+        const long double weight = static_cast<long double>(w);
+        if (n_ == 0) {
+            // Leaving a zero net count: rebuild the moments from the residual sums.
+            n_ = w;
+            const long double count = static_cast<long double>(n_);
+            mean_ = (zero_sum_ + weight * x) / count;
+            m2_ = zero_sum_sq_ + weight * x * x - count * mean_ * mean_;
+            zero_sum_ = zero_sum_sq_ = 0;
+            return;
+        }
+        if (n_ + w == 0) {
+            // Mean is undefined at a zero net count; an out-of-order erase may still leave signed
+            // sums behind, so keep them as plain sums until the count moves again.
+            const long double count = static_cast<long double>(n_);
+            zero_sum_ = count * mean_ + weight * x;
+            zero_sum_sq_ = m2_ + count * mean_ * mean_ + weight * x * x;
+            n_ = 0;
+            mean_ = m2_ = 0;
+            return;
+        }
+        n_ += w;
+        const long double delta = x - mean_;
+        mean_ += weight * delta / static_cast<long double>(n_);
+        m2_ += weight * delta * (x - mean_);
+    }
+
+    mutable std::mutex mtx_;
+    long long n_ = 0;
+    long double mean_ = 0;
+    long double m2_ = 0;
+    long double zero_sum_ = 0;     // sum and sum of squares while n_ == 0
+    long double zero_sum_sq_ = 0;
+};
+
+// Max minus min for AggMode::Range, from a pair of extremum indices.
+template <typename T, typename Id = std::size_t>
+class RangeTracker {
+public:
+    void insert(const T &v, Id id = Id{}) {
+        lo_.insert(v, id);
+        hi_.insert(v, id);
+    }
+    void erase_one(const T &v, Id id = Id{}) {
+        lo_.erase_one(v, id);
+        hi_.erase_one(v, id);
+    }
+    // The spread, or T{} when nothing is tracked.
+    T load() const {
+        auto lo = lo_.top();
+        auto hi = hi_.top();
+        if (!lo || !hi) return T{};
+        return static_cast<T>(*hi - *lo);
+    }
+
+private:
+    ShardedExtremumIndex<T, AggMode::Min, 16, Id> lo_;
+    ShardedExtremumIndex<T, AggMode::Max, 16, Id> hi_;
+};
+
+// Sum of extractor values for an AggMode::Add extra aggregate (Aggregate<T, AggMode::Add, F>): an
+// erase adds the wrapped negation, so integer sums wrap like DefaultApplyAdd.
+template <typename T, typename Id = std::size_t>
+class SumTracker {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<std::remove_cv_t<T>, bool>,
+                  "SumTracker needs an arithmetic total");
+
+public:
+    void insert(const T &v, Id = Id{}) noexcept { sum_.add(v); }
+    void erase_one(const T &v, Id = Id{}) noexcept { sum_.add(wrapping_subtract(T{}, v)); }
+    T load() const noexcept { return sum_.load(); }
+
+private:
+    AtomicTotal<T> sum_;
+};
+
+// Sum of the deltas added during the last `window`, bucketed into a ring of `slices` time slices.
+// Advancing the clock clears each expired slice once, so expiry is O(1) amortized per slice and
+// the window edge is accurate to one slice. Disabled (and free to skip) until configure().
+template <typename T, typename Clock = std::chrono::steady_clock>
+class SlidingWindowTotal {
+public:
+    using time_point = typename Clock::time_point;
+
+    void configure(std::chrono::nanoseconds window, std::size_t slices, time_point now = Clock::now()) {
+        if (window.count() <= 0 || slices == 0) throw std::invalid_argument("window and slices must be positive");
+        std::lock_guard<std::mutex> g(mtx_);
+        slice_ns_ = std::max<std::int64_t>(1, window.count() / static_cast<std::int64_t>(slices));
+        slices_.assign(slices, T{});
+        sum_ = T{};
+        head_ = slice_of(now);
+        enabled_.store(true, std::memory_order_release);
+    }
+    bool enabled() const noexcept { return enabled_.load(std::memory_order_acquire); }
+
+    template <typename D>
+    void add(const D &d, time_point now = Clock::now()) {
+        const T step = bounded_numeric_cast<T>(d);
+        std::lock_guard<std::mutex> g(mtx_);
+        if (slices_.empty()) return;
+        advance_locked(now);
+        T &slot = slices_[static_cast<std::size_t>(head_) % slices_.size()];
+        slot = wrapping_add(slot, step);
+        sum_ = wrapping_add(sum_, step);
+    }
+    // Window sum as of now (expiring slices that fell out of it).
+    T load(time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> g(mtx_);
+        if (slices_.empty()) return T{};
+        advance_locked(now);
+        return sum_;
+    }
+
+private:
+    std::int64_t slice_of(time_point now) const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count() / slice_ns_;
+    }
+    void advance_locked(time_point now) {
+        const std::int64_t target = slice_of(now);
+        if (target <= head_) return;  // same slice (or a clock read that raced behind)
+        const auto n = static_cast<std::int64_t>(slices_.size());
+        const std::int64_t steps = std::min(target - head_, n);
+        for (std::int64_t i = 1; i <= steps; ++i) {
+            T &slot = slices_[static_cast<std::size_t>(head_ + i) % slices_.size()];
+            sum_ = wrapping_subtract(sum_, slot);
+            slot = T{};
+        }
+        head_ = target;
+    }
+
+    std::mutex mtx_;
+    std::atomic<bool> enabled_{false};
+    std::vector<T> slices_;
+    T sum_{};
+    std::int64_t slice_ns_ = 1;
+    std::int64_t head_ = 0;  // absolute index of the newest slice
+};
+
+// Exponentially decayed sum of deltas: every delta loses half its weight per half_life. The decay
+// factor is applied lazily, once per add() or load(), against the time of the previous touch.
+template <typename Clock = std::chrono::steady_clock>
+class DecayedTotal {
+public:
+    using time_point = typename Clock::time_point;
+
+    void configure(std::chrono::nanoseconds half_life, time_point now = Clock::now()) {
+        if (half_life.count() <= 0) throw std::invalid_argument("half_life must be positive");
+        std::lock_guard<std::mutex> g(mtx_);
+        half_life_ns_ = static_cast<double>(half_life.count());
+        value_ = 0;
+        last_ = now;
+        enabled_.store(true, std::memory_order_release);
+    }
+    bool enabled() const noexcept { return enabled_.load(std::memory_order_acquire); }
+
+    template <typename D>
+    void add(const D &d, time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> g(mtx_);
+        decay_locked(now);
+        value_ += static_cast<double>(d);
+    }
+    double load(time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> g(mtx_);
+        decay_locked(now);
+        return value_;
+    }
+
+private:
+    void decay_locked(time_point now) {
+        if (now <= last_ || half_life_ns_ <= 0) return;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count();
+        value_ *= std::exp2(-static_cast<double>(elapsed) / half_life_ns_);
+        last_ = now;
+    }
+
+    std::mutex mtx_;
+    std::atomic<bool> enabled_{false};
+    double value_ = 0;
+    double half_life_ns_ = 0;
+    time_point last_{};
+};
+
+constexpr bool is_extremum_mode(AggMode m) noexcept { return m == AggMode::Min || m == AggMode::Max; }
+
+// Incremental state behind an extractor-driven total (every mode but Add for total1/total2; Add
+// too for extra aggregates).
+template <AggMode Mode, typename T, typename Id>
+struct extract_aggregate {
+    using type = ShardedExtremumIndex<T, Mode, 16, Id>;
+};
+template <typename T, typename Id>
+struct extract_aggregate<AggMode::Add, T, Id> {
+    using type = SumTracker<T, Id>;
+};
+template <typename T, typename Id>
+struct extract_aggregate<AggMode::Count, T, Id> {
+    using type = CountTracker<T, Id>;
+};
+template <typename T, typename Id>
+struct extract_aggregate<AggMode::Mean, T, Id> {
+    using type = MomentTracker<T, AggMode::Mean, Id>;
+};
+template <typename T, typename Id>
+struct extract_aggregate<AggMode::Variance, T, Id> {
+    using type = MomentTracker<T, AggMode::Variance, Id>;
+};
+template <typename T, typename Id>
+struct extract_aggregate<AggMode::Range, T, Id> {
+    using type = RangeTracker<T, Id>;
+};
+
 // Noop functors
 template <typename Elem1T, typename Elem2T, typename TotalT>
 struct NoopDelta {
@@ -149,6 +737,7 @@ struct NoopDelta {
 template <typename TotalT, typename DeltaT = TotalT>
 struct NoopApply {
     using DeltaType = DeltaT;
+    static constexpr bool lock_free_apply = true;
     constexpr bool operator()(TotalT& /*total*/, const DeltaT& /*d*/) const noexcept {
         return false;
     }
@@ -158,6 +747,7 @@ struct NoopApply {
 template <typename TotalT, typename DeltaT = TotalT>
 struct SetApply {
     using DeltaType = DeltaT;
+    static constexpr bool lock_free_apply = true;
     constexpr bool operator()(TotalT &total, const DeltaT &d) const noexcept {
         TotalT v = bounded_numeric_cast<TotalT>(d);
         if (total == v) return false;
@@ -170,6 +760,7 @@ struct SetApply {
 template <typename TotalT, typename DeltaT = TotalT>
 struct SaturatingApply {
     using DeltaType = DeltaT;
+    static constexpr bool lock_free_apply = true;
     TotalT minv;
     TotalT maxv;
     SaturatingApply(TotalT lo = std::numeric_limits<TotalT>::lowest(), TotalT hi = std::numeric_limits<TotalT>::max())
@@ -217,6 +808,941 @@ struct deduced_delta<TotalT, DeltaFn, std::void_t<typename DeltaFn::DeltaType>>
 template <typename TotalT, typename DeltaFn>
 using deduced_delta_t = typename deduced_delta<TotalT, DeltaFn>::type;
 
+// Number of worker threads to use for a parallel pass (requested == 0 -> hardware concurrency).
+inline std::size_t worker_count(std::size_t requested) noexcept {
+    if (requested != 0) return requested;
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<std::size_t>(hw);
+}
+
+// Run task(0..tasks-1) concurrently: tasks-1 helper threads plus the calling thread. Every
+// started thread is joined before the first exception (a task's, or a failed thread start) is
+// rethrown.
+template <typename Task>
+void run_parallel(std::size_t tasks, Task &&task) {
+    std::vector<std::exception_ptr> errors(tasks);
+    auto run = [&task, &errors](std::size_t t) {
+        try {
+            task(t);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    std::exception_ptr start_error;
+    try {
+        workers.reserve(tasks > 0 ? tasks - 1 : 0);
+        for (std::size_t t = 1; t < tasks; ++t) workers.emplace_back([&run, t] { run(t); });
+    } catch (...) {
+        start_error = std::current_exception();
+    }
+    if (tasks > 0 && !start_error) run(0);
+    for (auto &w : workers) w.join();
+    if (start_error) std::rethrow_exception(start_error);
+    for (auto &e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+// parallel_sort: sort chunks on separate threads, then merge adjacent runs pairwise (each merge
+// round also runs in parallel). Falls back to std::sort for small inputs or a single thread.
+template <typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare cmp, std::size_t threads) {
+    constexpr std::size_t min_chunk = 4096;
+    const auto n = static_cast<std::size_t>(last - first);
+    threads = std::min(worker_count(threads), std::max<std::size_t>(1, n / min_chunk));
+    if (threads <= 1) {
+        std::sort(first, last, cmp);
+        return;
+    }
+
+    std::vector<RandomIt> bounds;
+    bounds.reserve(threads + 1);
+    for (std::size_t t = 0; t <= threads; ++t) {
+        bounds.push_back(first + static_cast<std::ptrdiff_t>(n * t / threads));
+    }
+
+    run_parallel(threads, [&](std::size_t t) { std::sort(bounds[t], bounds[t + 1], cmp); });
+
+    for (std::size_t width = 1; width < threads; width *= 2) {
+        const std::size_t merges = (threads + 2 * width - 1) / (2 * width);
+        run_parallel(merges, [&](std::size_t m) {
+            const std::size_t lo = m * 2 * width;
+            const std::size_t mid = std::min(lo + width, threads);
+            const std::size_t hi = std::min(lo + 2 * width, threads);
+            if (mid < hi) std::inplace_merge(bounds[lo], bounds[mid], bounds[hi], cmp);
+        });
+    }
+}
+
+// SortedBlockSet: ordered set stored as a run of sorted, contiguous blocks of at most BlockSize
+// values (a two-level B+tree). maxes_ mirrors the last value of every block so locating a block
+// is a binary search over one contiguous array; iteration streams through each block in order.
+// A Fenwick tree over block sizes (counts_) provides rank()/select() in O(log n).
+// Exposes the subset of the std::set interface used by the ordered index. Values are immutable
+// through iterators; any mutation invalidates all iterators.
+template <typename T, typename Compare, std::size_t BlockSize>
+class SortedBlockSet {
+    static_assert(BlockSize >= 4, "SortedBlockSet: BlockSize must be at least 4");
+    using block_type = std::vector<T>;
+
+public:
+    using value_type = T;
+    using key_compare = Compare;
+    using size_type = std::size_t;
+
+    class const_iterator {
+        const SortedBlockSet *set_ = nullptr;
+        size_type block_ = 0;
+        size_type pos_ = 0;
+        friend class SortedBlockSet;
+        const_iterator(const SortedBlockSet *s, size_type b, size_type p) : set_(s), block_(b), pos_(p) {}
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return set_->blocks_[block_][pos_]; }
+        pointer operator->() const { return &set_->blocks_[block_][pos_]; }
+
+        const_iterator& operator++() {
+            if (++pos_ == set_->blocks_[block_].size()) { ++block_; pos_ = 0; }
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator tmp = *this; ++*this; return tmp; }
+        const_iterator& operator--() {
+            if (pos_ == 0) { --block_; pos_ = set_->blocks_[block_].size() - 1; }
+            else --pos_;
+            return *this;
+        }
+        const_iterator operator--(int) { const_iterator tmp = *this; --*this; return tmp; }
+
+        bool operator==(const const_iterator &o) const { return block_ == o.block_ && pos_ == o.pos_; }
+        bool operator!=(const const_iterator &o) const { return !(*this == o); }
+    };
+    using iterator = const_iterator;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator = const_reverse_iterator;
+
+    SortedBlockSet() = default;
+    explicit SortedBlockSet(Compare cmp) : cmp_(std::move(cmp)) {}
+
+    [[nodiscard]] size_type size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    void clear() noexcept { blocks_.clear(); maxes_.clear(); counts_.clear(); size_ = 0; }
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, blocks_.size(), 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    std::pair<const_iterator, bool> insert(const T &v) {
+        if (blocks_.empty()) {
+            blocks_.emplace_back();
+            blocks_.back().reserve(BlockSize);
+            blocks_.back().push_back(v);
+            maxes_.push_back(v);
+            ++size_;
+            rebuild_counts();
+            return { begin(), true };
+        }
+        size_type b = block_for(v);
+        if (b == blocks_.size()) --b;  // larger than everything: append to the last block
+        block_type &blk = blocks_[b];
+        auto pos = std::lower_bound(blk.begin(), blk.end(), v, cmp_);
+        if (pos != blk.end() && !cmp_(v, *pos)) {
+            return { const_iterator(this, b, static_cast<size_type>(pos - blk.begin())), false };
+        }
+        size_type p = static_cast<size_type>(pos - blk.begin());
+        blk.insert(pos, v);
+        maxes_[b] = blk.back();
+        ++size_;
+        if (blk.size() > BlockSize) {
+            split_block(b);
+            rebuild_counts();
+            if (p >= blocks_[b].size()) { p -= blocks_[b].size(); ++b; }
+        } else {
+            counts_add(b, 1);
+        }
+        return { const_iterator(this, b, p), true };
+    }
+
+    size_type erase(const T &v) {
+        size_type b = 0, p = 0;
+        if (!locate(v, b, p)) return 0;
+        erase_at(b, p);
+        return 1;
+    }
+
+    [[nodiscard]] const_iterator find(const T &v) const {
+        size_type b = 0, p = 0;
+        return locate(v, b, p) ? const_iterator(this, b, p) : end();
+    }
+
+    // First value not less than v (end() if none). O(log n).
+    template <typename K>
+    [[nodiscard]] const_iterator lower_bound(const K &v) const {
+        const size_type b = block_for(v);
+        if (b == blocks_.size()) return end();
+        const block_type &blk = blocks_[b];
+        auto pos = std::lower_bound(blk.begin(), blk.end(), v, cmp_);
+        return const_iterator(this, b, static_cast<size_type>(pos - blk.begin()));
+    }
+
+    // Zero-based position of it in sorted order (size() for end()).
+    [[nodiscard]] size_type rank(const_iterator it) const {
+        if (it.block_ >= blocks_.size()) return size_;
+        return counts_prefix(it.block_) + it.pos_;
+    }
+
+    // Iterator to the value at zero-based position k (end() if k >= size()).
+    [[nodiscard]] const_iterator select(size_type k) const {
+        if (k >= size_) return end();
+        size_type block = 0;
+        size_type step = 1;
+        while ((step << 1) <= blocks_.size()) step <<= 1;
+        for (; step > 0; step >>= 1) {
+            if (block + step <= blocks_.size() && counts_[block + step] <= k) {
+                block += step;
+                k -= counts_[block];
+            }
+        }
+        return const_iterator(this, block, k);
+    }
+
+    // Bulk-load from values already sorted by the comparator (duplicates not allowed). O(n).
+    // Blocks are filled to 3/4 of BlockSize so subsequent inserts rarely split immediately.
+    void assign_sorted(std::vector<T> &&sorted) {
+        clear();
+        const size_type fill = std::max<size_type>(1, BlockSize - BlockSize / 4);
+        blocks_.reserve(sorted.size() / fill + 1);
+        for (size_type i = 0; i < sorted.size(); i += fill) {
+            const size_type last = std::min(sorted.size(), i + fill);
+            block_type blk;
+            blk.reserve(BlockSize);
+            blk.assign(std::make_move_iterator(sorted.begin() + static_cast<std::ptrdiff_t>(i)),
+                       std::make_move_iterator(sorted.begin() + static_cast<std::ptrdiff_t>(last)));
+            maxes_.push_back(blk.back());
+            blocks_.push_back(std::move(blk));
+        }
+        size_ = sorted.size();
+        rebuild_counts();
+    }
+
+    // Replace old_value by new_value. Overwrites in place when new_value keeps the same position,
+    // otherwise falls back to erase + insert.
+    void replace(const T &old_value, const T &new_value) {
+        size_type b = 0, p = 0;
+        if (!locate(old_value, b, p)) {
+            insert(new_value);
+            return;
+        }
+        block_type &blk = blocks_[b];
+        const bool after_prev = (p > 0) ? cmp_(blk[p - 1], new_value)
+                                        : (b == 0 || cmp_(maxes_[b - 1], new_value));
+        const bool before_next = (p + 1 < blk.size()) ? cmp_(new_value, blk[p + 1])
+                                                      : (b + 1 == blocks_.size() || cmp_(new_value, blocks_[b + 1].front()));
+        if (after_prev && before_next) {
+            blk[p] = new_value;
+            if (p + 1 == blk.size()) maxes_[b] = new_value;
+            return;
+        }
+        erase_at(b, p);
+        insert(new_value);
+    }
+
+private:
+    // Index of the first block whose last value is not less than v (blocks_.size() if none).
+    template <typename K>
+    size_type block_for(const K &v) const {
+        auto it = std::lower_bound(maxes_.begin(), maxes_.end(), v, cmp_);
+        return static_cast<size_type>(it - maxes_.begin());
+    }
+
+    bool locate(const T &v, size_type &b, size_type &p) const {
+        b = block_for(v);
+        if (b == blocks_.size()) return false;
+        const block_type &blk = blocks_[b];
+        auto pos = std::lower_bound(blk.begin(), blk.end(), v, cmp_);
+        if (pos == blk.end() || cmp_(v, *pos)) return false;
+        p = static_cast<size_type>(pos - blk.begin());
+        return true;
+    }
+
+    void split_block(size_type b) {
+        block_type &blk = blocks_[b];
+        const size_type half = blk.size() / 2;
+        block_type upper;
+        upper.reserve(BlockSize);
+        upper.assign(std::make_move_iterator(blk.begin() + static_cast<std::ptrdiff_t>(half)),
+                     std::make_move_iterator(blk.end()));
+        blk.erase(blk.begin() + static_cast<std::ptrdiff_t>(half), blk.end());
+        maxes_[b] = blk.back();
+        maxes_.insert(maxes_.begin() + static_cast<std::ptrdiff_t>(b + 1), upper.back());
+        blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(b + 1), std::move(upper));
+    }
+
+    void erase_at(size_type b, size_type p) {
+        block_type &blk = blocks_[b];
+        blk.erase(blk.begin() + static_cast<std::ptrdiff_t>(p));
+        --size_;
+        if (blk.empty()) {
+            blocks_.erase(blocks_.begin() + static_cast<std::ptrdiff_t>(b));
+            maxes_.erase(maxes_.begin() + static_cast<std::ptrdiff_t>(b));
+            rebuild_counts();
+            return;
+        }
+        maxes_[b] = blk.back();
+        // Fold an underfull block into its successor's space to keep blocks dense.
+        if (blk.size() < BlockSize / 4 && b + 1 < blocks_.size() &&
+            blk.size() + blocks_[b + 1].size() <= BlockSize) {
+            block_type &next = blocks_[b + 1];
+            blk.insert(blk.end(), std::make_move_iterator(next.begin()), std::make_move_iterator(next.end()));
+            maxes_[b] = blk.back();
+            blocks_.erase(blocks_.begin() + static_cast<std::ptrdiff_t>(b + 1));
+            maxes_.erase(maxes_.begin() + static_cast<std::ptrdiff_t>(b + 1));
+            rebuild_counts();
+            return;
+        }
+        counts_sub(b, 1);
+    }
+
+    // Fenwick tree helpers (counts_ is 1-based; counts_[0] unused).
+    void rebuild_counts() {
+        counts_.assign(blocks_.size() + 1, 0);
+        for (size_type i = 1; i <= blocks_.size(); ++i) {
+            counts_[i] += blocks_[i - 1].size();
+            const size_type parent = i + (i & (~i + 1));
+            if (parent <= blocks_.size()) counts_[parent] += counts_[i];
+        }
+    }
+    void counts_add(size_type b, size_type n) {
+        for (size_type i = b + 1; i <= blocks_.size(); i += i & (~i + 1)) counts_[i] += n;
+    }
+    void counts_sub(size_type b, size_type n) {
+        for (size_type i = b + 1; i <= blocks_.size(); i += i & (~i + 1)) counts_[i] -= n;
+    }
+    // Number of values stored in blocks [0, b).
+    size_type counts_prefix(size_type b) const {
+        size_type sum = 0;
+        for (size_type i = b; i > 0; i -= i & (~i + 1)) sum += counts_[i];
+        return sum;
+    }
+
+    std::vector<block_type> blocks_;
+    std::vector<T> maxes_;
+    std::vector<size_type> counts_;
+    Compare cmp_{};
+    size_type size_ = 0;
+};
+
+// Exact quantiles for AggMode::Quantile: (value, element id) entries in a SortedBlockSet, whose
+// Fenwick-indexed select() finds any order statistic in O(log n). quantile(q) interpolates
+// linearly between the two order statistics around q * (n - 1) (lower one for non-arithmetic T).
+// load() reports the first configured quantile (the median by default). An erase that lands
+// before the insert it undoes is parked and cancels that insert.
+template <typename T, typename Id = std::size_t, std::size_t BlockSize = 64>
+class QuantileTracker {
+public:
+    using entry_type = std::pair<T, Id>;
+
+    void insert(const T &v, Id id = Id{}) {
+        std::lock_guard<std::mutex> g(mtx_);
+        const entry_type entry{v, id};
+        if (auto it = pending_erase_.find(entry); it != pending_erase_.end()) {
+            if (--it->second == 0) pending_erase_.erase(it);
+            return;
+        }
+        set_.insert(entry);
+    }
+    void erase_one(const T &v, Id id = Id{}) {
+        std::lock_guard<std::mutex> g(mtx_);
+        const entry_type entry{v, id};
+        if (set_.erase(entry) == 0) ++pending_erase_[entry];
+    }
+
+    // Replaces the reported quantiles; each must lie in [0, 1] and at least one is required.
+    void set_quantiles(std::vector<double> qs) {
+        if (qs.empty()) throw std::invalid_argument("set_quantiles: no quantiles");
+        for (double q : qs) {
+            if (!(q >= 0.0 && q <= 1.0)) throw std::invalid_argument("set_quantiles: quantile outside [0, 1]");
+        }
+        std::lock_guard<std::mutex> g(mtx_);
+        qs_ = std::move(qs);
+    }
+    std::vector<double> quantiles() const {
+        std::lock_guard<std::mutex> g(mtx_);
+        return qs_;
+    }
+
+    // The q-quantile, or T{} when nothing is tracked. O(log n).
+    T quantile(double q) const {
+        std::lock_guard<std::mutex> g(mtx_);
+        return quantile_locked(std::clamp(q, 0.0, 1.0));
+    }
+    // The configured quantiles, in configuration order.
+    std::vector<T> values() const {
+        std::lock_guard<std::mutex> g(mtx_);
+        std::vector<T> out;
+        out.reserve(qs_.size());
+        for (double q : qs_) out.push_back(quantile_locked(q));
+        return out;
+    }
+    T load() const {
+        std::lock_guard<std::mutex> g(mtx_);
+        return quantile_locked(qs_.front());
+    }
+    std::size_t size() const {
+        std::lock_guard<std::mutex> g(mtx_);
+        return set_.size();
+    }
+
+private:
+    T quantile_locked(double q) const {
+        if (set_.empty()) return T{};
+        const double pos = q * static_cast<double>(set_.size() - 1);
+        const auto lo = static_cast<std::size_t>(pos);
+        const T low = set_.select(lo)->first;
+        if constexpr (std::is_arithmetic_v<T>) {
+            const double frac = pos - static_cast<double>(lo);
+            if (frac == 0.0 || lo + 1 >= set_.size()) return low;
+            const T high = set_.select(lo + 1)->first;
+            const long double mixed = static_cast<long double>(low) +
+                static_cast<long double>(frac) * (static_cast<long double>(high) - static_cast<long double>(low));
+            return bounded_numeric_cast<T>(mixed);
+        } else {
+            return low;
+        }
+    }
+
+    mutable std::mutex mtx_;
+    SortedBlockSet<entry_type, std::less<entry_type>, BlockSize> set_;
+    std::map<entry_type, std::size_t> pending_erase_;
+    std::vector<double> qs_{0.5};
+};
+
+template <typename T, typename Id>
+struct extract_aggregate<AggMode::Quantile, T, Id> {
+    using type = QuantileTracker<T, Id>;
+};
+
+// TopKSet: keeps only the greatest K..K+Slack values of a larger population, as an ordered
+// prefix of the full order. Its smallest tracked value is the admission threshold: inserts
+// and erases of values below it are rejected by one comparison. When erases shrink the prefix
+// below K, needs_refill() asks the owner to scan the population for untracked candidates
+// (values ordered before threshold()); Slack amortizes those scans over several erases.
+// complete() means every value of the population is tracked (no threshold).
+template <typename T, typename Compare, std::size_t K, std::size_t Slack>
+class TopKSet {
+    static_assert(K > 0, "TopKSet: K must be positive");
+    using set_type = std::set<T, Compare>;
+
+public:
+    using value_type = T;
+    using key_compare = Compare;
+    using size_type = std::size_t;
+    using const_iterator = typename set_type::const_iterator;
+    using iterator = const_iterator;
+    using const_reverse_iterator = typename set_type::const_reverse_iterator;
+    using reverse_iterator = const_reverse_iterator;
+    static constexpr size_type capacity = K + Slack;
+
+    TopKSet() = default;
+    explicit TopKSet(Compare cmp) : set_(std::move(cmp)) {}
+
+    [[nodiscard]] size_type size() const noexcept { return set_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return set_.empty(); }
+    [[nodiscard]] bool complete() const noexcept { return complete_; }
+    [[nodiscard]] key_compare key_comp() const { return set_.key_comp(); }
+
+    const_iterator begin() const { return set_.cbegin(); }
+    const_iterator end() const { return set_.cend(); }
+    const_iterator cbegin() const { return set_.cbegin(); }
+    const_iterator cend() const { return set_.cend(); }
+    const_reverse_iterator rbegin() const { return set_.crbegin(); }
+    const_reverse_iterator rend() const { return set_.crend(); }
+    const_reverse_iterator crbegin() const { return set_.crbegin(); }
+    const_reverse_iterator crend() const { return set_.crend(); }
+
+    [[nodiscard]] const_iterator find(const T &v) const { return set_.find(v); }
+    template <typename Key>
+    [[nodiscard]] const_iterator lower_bound(const Key &v) const { return set_.lower_bound(v); }
+
+    // True when v is inside the tracked prefix (one comparison against the threshold).
+    [[nodiscard]] bool tracks(const T &v) const {
+        return complete_ || (!set_.empty() && !set_.key_comp()(v, *set_.begin()));
+    }
+
+    // Smallest tracked value; untracked values all order before it. nullptr when complete or empty.
+    [[nodiscard]] const T *threshold() const { return (complete_ || set_.empty()) ? nullptr : &*set_.begin(); }
+
+    [[nodiscard]] bool needs_refill() const noexcept { return !complete_ && set_.size() < K; }
+
+    // Free slots a refill may fill.
+    [[nodiscard]] size_type refill_room() const noexcept { return capacity - std::min(capacity, set_.size()); }
+
+    bool insert(const T &v) {
+        if (!tracks(v)) return false;  // below the threshold (or a refill is pending)
+        const bool inserted = set_.insert(v).second;
+        if (set_.size() > capacity) {
+            set_.erase(set_.begin());
+            complete_ = false;
+        }
+        return inserted;
+    }
+
+    size_type erase(const T &v) { return tracks(v) ? set_.erase(v) : 0; }
+
+    void replace(const T &old_value, const T &new_value) {
+        erase(old_value);
+        insert(new_value);
+    }
+
+    // Add the best untracked candidates found by the owner's scan (at most refill_room(), all
+    // ordered before threshold()). scanned_all: the candidates are every untracked value.
+    void refill(std::vector<T> &&candidates, bool scanned_all) {
+        for (auto &v : candidates) set_.insert(std::move(v));
+        while (set_.size() > capacity) set_.erase(set_.begin());
+        complete_ = scanned_all;
+    }
+
+    // Bulk-load from a sorted population, keeping its greatest capacity values.
+    void assign_sorted(std::vector<T> &&sorted) {
+        set_.clear();
+        complete_ = sorted.size() <= capacity;
+        const size_type skip = complete_ ? 0 : sorted.size() - capacity;
+        for (size_type i = skip; i < sorted.size(); ++i) set_.insert(set_.end(), std::move(sorted[i]));
+    }
+
+private:
+    set_type set_;
+    bool complete_ = true;
+};
+
+// EpochDomain: epoch-based reclamation for lock-free readers. A traversal pins the current epoch;
+// objects retired while the domain is in epoch e are destroyed once the epoch has advanced past
+// e and nobody is still pinned in it. The epoch only advances after the previous one drained,
+// so two parity counters are enough to track every pinned thread.
+class EpochDomain {
+public:
+    class Guard {
+    public:
+        Guard() = default;
+        explicit Guard(const EpochDomain &domain) : domain_(&domain), parity_(domain.enter()) {}
+        Guard(Guard &&other) noexcept : domain_(std::exchange(other.domain_, nullptr)), parity_(other.parity_) {}
+        Guard &operator=(Guard &&other) noexcept {
+            if (this != &other) {
+                release();
+                domain_ = std::exchange(other.domain_, nullptr);
+                parity_ = other.parity_;
+            }
+            return *this;
+        }
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+        ~Guard() { release(); }
+
+        void release() {
+            if (domain_) domain_->exit(parity_);
+            domain_ = nullptr;
+        }
+
+    private:
+        const EpochDomain *domain_ = nullptr;
+        std::size_t parity_ = 0;
+    };
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+    ~EpochDomain() {
+        for (auto &list : limbo_) {
+            for (auto &r : list) r.destroy(r.ptr);
+        }
+    }
+
+    [[nodiscard]] Guard pin() const { return Guard(*this); }
+
+    // Hand over an object that is no longer reachable from the structure; it is destroyed once
+    // every traversal that might still hold it has unpinned.
+    template <typename T>
+    void retire(T *ptr) {
+        std::lock_guard<std::mutex> g(mtx_);
+        limbo_[epoch_.load() & 1].push_back({ptr, [](void *p) { delete static_cast<T *>(p); }});
+        if (++retired_since_advance_ >= advance_every) try_advance_locked();
+    }
+
+    void try_reclaim() {
+        std::lock_guard<std::mutex> g(mtx_);
+        try_advance_locked();
+    }
+
+    [[nodiscard]] std::size_t pending() const {
+        std::lock_guard<std::mutex> g(mtx_);
+        return limbo_[0].size() + limbo_[1].size();
+    }
+
+private:
+    struct Retired {
+        void *ptr;
+        void (*destroy)(void *);
+    };
+    static constexpr std::size_t advance_every = 64;
+
+    std::size_t enter() const {
+        for (;;) {
+            const std::uint64_t e = epoch_.load();
+            const auto parity = static_cast<std::size_t>(e & 1);
+            active_[parity].fetch_add(1);
+            if (epoch_.load() == e) return parity;
+            active_[parity].fetch_sub(1);  // raced with an advance; pin the new epoch instead
+        }
+    }
+    void exit(std::size_t parity) const { active_[parity].fetch_sub(1); }
+
+    // In epoch e, limbo_[(e + 1) & 1] holds objects retired during e - 1. Once nobody is pinned
+    // in e - 1 they are unreachable: every live pin started after they were unlinked.
+    void try_advance_locked() {
+        const std::uint64_t e = epoch_.load();
+        const auto previous = static_cast<std::size_t>((e + 1) & 1);
+        if (active_[previous].load() != 0) return;
+        std::vector<Retired> reclaim;
+        reclaim.swap(limbo_[previous]);
+        epoch_.store(e + 1);
+        retired_since_advance_ = 0;
+        for (auto &r : reclaim) r.destroy(r.ptr);
+    }
+
+    std::atomic<std::uint64_t> epoch_{0};
+    mutable std::atomic<std::size_t> active_[2]{{0}, {0}};
+    mutable std::mutex mtx_;
+    std::vector<Retired> limbo_[2];
+    std::size_t retired_since_advance_ = 0;
+};
+
+// ConcurrentSkipList: lazy concurrent skip list (Herlihy, Lev, Luchangco, Shavit). Writers lock
+// only the predecessors they relink (per-node spinlocks), so inserts and erases of different
+// values proceed in parallel; lookups and iteration never lock, skipping nodes that are logically
+// deleted or not yet fully linked. Unlinked nodes are reclaimed through an EpochDomain: mutators
+// pin it internally, while iterators are only valid under a guard obtained from pin().
+// Exposes the subset of the std::set interface used by the ordered index.
+template <typename T, typename Compare, std::size_t MaxLevel = 24>
+class ConcurrentSkipList {
+    struct Node {
+        T value;
+        const std::size_t height;
+        std::unique_ptr<std::atomic<Node *>[]> next;
+        std::atomic<bool> marked{false};
+        std::atomic<bool> fully_linked{false};
+        std::atomic<bool> locked{false};
+
+        Node(T v, std::size_t h) : value(std::move(v)), height(h), next(new std::atomic<Node *>[h]) {
+            for (std::size_t i = 0; i < h; ++i) next[i].store(nullptr, std::memory_order_relaxed);
+        }
+        void lock() {
+            while (locked.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+        }
+        void unlock() { locked.store(false, std::memory_order_release); }
+        bool live() const {
+            return fully_linked.load(std::memory_order_acquire) && !marked.load(std::memory_order_acquire);
+        }
+    };
+
+public:
+    using value_type = T;
+    using key_compare = Compare;
+    using size_type = std::size_t;
+
+    class const_iterator {
+        const ConcurrentSkipList *list_ = nullptr;
+        Node *node_ = nullptr;  // nullptr is end()
+        friend class ConcurrentSkipList;
+        const_iterator(const ConcurrentSkipList *l, Node *n) : list_(l), node_(n) {}
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        reference operator*() const { return node_->value; }
+        pointer operator->() const { return &node_->value; }
+        const_iterator &operator++() {
+            node_ = list_->next_live(node_);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        // O(log n): re-descends from the head to the last live node before this one.
+        const_iterator &operator--() {
+            node_ = list_->last_live_before(node_ ? &node_->value : nullptr);
+            return *this;
+        }
+        const_iterator operator--(int) {
+            auto tmp = *this;
+            --*this;
+            return tmp;
+        }
+        bool operator==(const const_iterator &o) const { return node_ == o.node_; }
+        bool operator!=(const const_iterator &o) const { return node_ != o.node_; }
+    };
+    using iterator = const_iterator;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator = const_reverse_iterator;
+
+    explicit ConcurrentSkipList(const Compare &cmp = Compare()) : cmp_(cmp), head_(new Node(T{}, MaxLevel)) {}
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+    ~ConcurrentSkipList() {
+        clear_nodes();
+        delete head_;
+    }
+
+    [[nodiscard]] EpochDomain::Guard pin() const { return domain_.pin(); }
+
+    const_iterator begin() const { return const_iterator(this, next_live(head_)); }
+    const_iterator end() const { return const_iterator(this, nullptr); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    size_type size() const { return size_.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    std::pair<const_iterator, bool> insert(const T &value) {
+        auto guard = domain_.pin();
+        const std::size_t height = random_height();
+        Node *preds[MaxLevel];
+        Node *succs[MaxLevel];
+        for (;;) {
+            const int found = locate(value, preds, succs);
+            if (found >= 0) {
+                Node *existing = succs[found];
+                if (!existing->marked.load(std::memory_order_acquire)) {
+                    while (!existing->fully_linked.load(std::memory_order_acquire)) std::this_thread::yield();
+                    return {const_iterator(this, existing), false};
+                }
+                continue;  // an erase is unlinking it; retry afterwards
+            }
+            std::size_t locked = 0;
+            bool valid = true;
+            for (std::size_t level = 0; valid && level < height; ++level) {
+                Node *pred = preds[level];
+                Node *succ = succs[level];
+                if (level == 0 || pred != preds[level - 1]) pred->lock();
+                locked = level + 1;
+                valid = !pred->marked.load(std::memory_order_acquire) &&
+                        (!succ || !succ->marked.load(std::memory_order_acquire)) &&
+                        pred->next[level].load(std::memory_order_acquire) == succ;
+            }
+            if (!valid) {
+                unlock_preds(preds, locked);
+                continue;
+            }
+            Node *node = new Node(value, height);
+            for (std::size_t level = 0; level < height; ++level) node->next[level].store(succs[level], std::memory_order_relaxed);
+            for (std::size_t level = 0; level < height; ++level) preds[level]->next[level].store(node, std::memory_order_release);
+            node->fully_linked.store(true, std::memory_order_release);
+            unlock_preds(preds, height);
+            size_.fetch_add(1, std::memory_order_acq_rel);
+            return {const_iterator(this, node), true};
+        }
+    }
+
+    size_type erase(const T &value) {
+        auto guard = domain_.pin();
+        Node *preds[MaxLevel];
+        Node *succs[MaxLevel];
+        Node *victim = nullptr;
+        for (;;) {
+            const int found = locate(value, preds, succs);
+            if (!victim) {
+                if (found < 0) return 0;
+                Node *candidate = succs[found];
+                // Only a fully linked node found at its top level can be erased (lazy skip list rule).
+                if (!candidate->live() || candidate->height != static_cast<std::size_t>(found) + 1) return 0;
+                victim = candidate;
+                victim->lock();
+                if (victim->marked.load(std::memory_order_acquire)) {
+                    victim->unlock();
+                    return 0;
+                }
+                victim->marked.store(true, std::memory_order_release);  // logical delete
+            }
+            const std::size_t height = victim->height;
+            std::size_t locked = 0;
+            bool valid = true;
+            for (std::size_t level = 0; valid && level < height; ++level) {
+                Node *pred = preds[level];
+                if (level == 0 || pred != preds[level - 1]) pred->lock();
+                locked = level + 1;
+                valid = !pred->marked.load(std::memory_order_acquire) &&
+                        pred->next[level].load(std::memory_order_acquire) == victim;
+            }
+            if (!valid) {
+                unlock_preds(preds, locked);
+                continue;
+            }
+            for (std::size_t level = height; level-- > 0;) {
+                preds[level]->next[level].store(victim->next[level].load(std::memory_order_acquire), std::memory_order_release);
+            }
+            victim->unlock();
+            unlock_preds(preds, height);
+            size_.fetch_sub(1, std::memory_order_acq_rel);
+            domain_.retire(victim);
+            return 1;
+        }
+    }
+
+    // Not atomic: concurrent readers may briefly see neither entry while it moves.
+    void replace(const T &old_value, const T &new_value) {
+        erase(old_value);
+        insert(new_value);
+    }
+
+    const_iterator find(const T &value) const {
+        Node *pred = head_;
+        for (std::size_t level = MaxLevel; level-- > 0;) {
+            Node *curr = pred->next[level].load(std::memory_order_acquire);
+            while (curr && cmp_(curr->value, value)) {
+                pred = curr;
+                curr = pred->next[level].load(std::memory_order_acquire);
+            }
+            if (curr && !cmp_(value, curr->value)) {
+                return curr->live() ? const_iterator(this, curr) : end();
+            }
+        }
+        return end();
+    }
+
+    // First live value not less than value (end() if none). O(log n) expected.
+    const_iterator lower_bound(const T &value) const {
+        Node *pred = head_;
+        for (std::size_t level = MaxLevel; level-- > 0;) {
+            Node *curr = pred->next[level].load(std::memory_order_acquire);
+            while (curr && cmp_(curr->value, value)) {
+                pred = curr;
+                curr = pred->next[level].load(std::memory_order_acquire);
+            }
+        }
+        // A concurrent insert may have landed between pred and value since the descent.
+        Node *n = pred->next[0].load(std::memory_order_acquire);
+        while (n && (!n->live() || cmp_(n->value, value))) n = n->next[0].load(std::memory_order_acquire);
+        return const_iterator(this, n);
+    }
+
+    // Replace the contents with already-sorted unique values in O(n). Not safe against concurrent
+    // access: used to build a fresh list before it is published.
+    void assign_sorted(std::vector<T> &&sorted) {
+        clear_nodes();
+        Node *last[MaxLevel];
+        for (auto &slot : last) slot = head_;
+        for (auto &value : sorted) {
+            Node *node = new Node(std::move(value), random_height());
+            for (std::size_t level = 0; level < node->height; ++level) {
+                last[level]->next[level].store(node, std::memory_order_relaxed);
+                last[level] = node;
+            }
+            node->fully_linked.store(true, std::memory_order_relaxed);
+        }
+        size_.store(sorted.size(), std::memory_order_release);
+    }
+
+private:
+    // Fill preds/succs around value at every level; returns the highest level holding an equal node or -1.
+    int locate(const T &value, Node **preds, Node **succs) const {
+        int found = -1;
+        Node *pred = head_;
+        for (std::size_t level = MaxLevel; level-- > 0;) {
+            Node *curr = pred->next[level].load(std::memory_order_acquire);
+            while (curr && cmp_(curr->value, value)) {
+                pred = curr;
+                curr = pred->next[level].load(std::memory_order_acquire);
+            }
+            if (found < 0 && curr && !cmp_(value, curr->value)) found = static_cast<int>(level);
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return found;
+    }
+
+    static void unlock_preds(Node *const *preds, std::size_t count) {
+        for (std::size_t level = 0; level < count; ++level) {
+            if (level == 0 || preds[level] != preds[level - 1]) preds[level]->unlock();
+        }
+    }
+
+    Node *next_live(Node *node) const {
+        Node *n = node->next[0].load(std::memory_order_acquire);
+        while (n && !n->live()) n = n->next[0].load(std::memory_order_acquire);
+        return n;
+    }
+
+    // Last live node ordered before *bound (before end() when bound is null); nullptr if none.
+    Node *last_live_before(const T *bound) const {
+        for (;;) {
+            Node *pred = head_;
+            for (std::size_t level = MaxLevel; level-- > 0;) {
+                Node *curr = pred->next[level].load(std::memory_order_acquire);
+                while (curr && (!bound || cmp_(curr->value, *bound))) {
+                    pred = curr;
+                    curr = pred->next[level].load(std::memory_order_acquire);
+                }
+            }
+            if (pred == head_) return nullptr;
+            if (pred->live()) return pred;
+            bound = &pred->value;  // mid-insert or mid-erase: look further left (pinned, so still readable)
+        }
+    }
+
+    // Geometric height with p = 1/4 from a per-thread xorshift generator.
+    static std::size_t random_height() {
+        thread_local std::uint64_t state =
+            0x9E3779B97F4A7C15ULL ^ static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&state));
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::uint64_t bits = state;
+        std::size_t height = 1;
+        while (height < MaxLevel && (bits & 3) == 0) {
+            ++height;
+            bits >>= 2;
+        }
+        return height;
+    }
+
+    void clear_nodes() {
+        Node *n = head_->next[0].load(std::memory_order_relaxed);
+        while (n) {
+            Node *next = n->next[0].load(std::memory_order_relaxed);
+            delete n;
+            n = next;
+        }
+        for (std::size_t level = 0; level < MaxLevel; ++level) head_->next[level].store(nullptr, std::memory_order_relaxed);
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    Compare cmp_;
+    Node *head_;
+    std::atomic<size_type> size_{0};
+    mutable EpochDomain domain_;
+};
+
 } // namespace detail
 
 // ============================================================================
@@ -248,6 +1774,174 @@ struct DefaultCompare {
     }
 };
 
+// Declares ExtractFn monotone in CompareFn's order: whenever CompareFn puts element a before b,
+// extract(a) <= extract(b). Specialize to std::true_type so Min/Max totals of an ordered
+// collection read the index ends instead of maintaining a separate extremum index.
+template <typename ExtractFn, typename CompareFn>
+struct extract_monotone_with_compare : std::false_type {};
+
+//==============================================================================
+// ORDERED INDEX POLICIES
+//==============================================================================
+
+// IdOrderedIndex: tree of ids; every comparison re-reads lastElem1/lastElem2 from elems_.
+struct IdOrderedIndex {};
+
+// CachedKeyOrderedIndex: tree of (lastElem1, lastElem2, id) entries. Comparisons touch only
+// node memory; the collection refreshes the cached keys inside its erase/reinsert sequence.
+struct CachedKeyOrderedIndex {};
+
+// SortedBlockOrderedIndex: cached-key entries kept in contiguous sorted blocks of at most
+// BlockSize entries (detail::SortedBlockSet), so ordered iteration streams through memory.
+template <std::size_t BlockSize = 256>
+struct SortedBlockOrderedIndex {
+    static constexpr std::size_t block_size = BlockSize;
+};
+
+// MaintainTopK: cached-key index that tracks only the greatest K (up to K + Slack) entries
+// (detail::TopKSet). Updates below the admission threshold cost one comparison; a scan of the
+// elements refills the set when erases or demotions leave fewer than K tracked entries.
+// ordered(), bottom_k(), rank() and friends see only the tracked entries; top_k(k) is exact for
+// k <= K.
+template <std::size_t K, std::size_t Slack = K>
+struct MaintainTopK {
+    static constexpr std::size_t k = K;
+    static constexpr std::size_t slack = Slack;
+};
+
+// ConcurrentSkipListOrderedIndex: cached-key entries in a lazy concurrent skip list
+// (detail::ConcurrentSkipList). Writers take ordered_mtx_ shared and relink under per-node locks,
+// so updates of different elements run in parallel and ordered() readers never block writers.
+struct ConcurrentSkipListOrderedIndex {};
+
+// Timing breakdown of the last ordered-index rebuild (set_compare / rebuild_ordered_index).
+struct OrderedRebuildStats {
+    std::size_t elements = 0;          // entries in the rebuilt index
+    std::size_t replayed_changes = 0;  // writer changes logged during the rebuild and replayed at swap
+    std::size_t threads = 1;           // worker threads used for snapshot and sort
+    std::chrono::microseconds snapshot_time{0};
+    std::chrono::microseconds sort_time{0};
+    std::chrono::microseconds build_time{0};
+    std::chrono::microseconds swap_time{0};  // time ordered_mtx_ was held exclusively at the end
+};
+
+// When total1Var()/total2Var() (and their argtotal/quantile Vars), the extra aggregates' Vars and
+// the group Vars are written; see set_publication_policy(). total1()/total2() always read the exact
+// totals, only the reactive copies are coalesced. Var-backed Add totals (custom apply functors without lock_free_apply,
+// non-arithmetic totals) are the authoritative value and keep publishing on every change.
+struct PublicationPolicy {
+    enum class Mode { Immediate, EveryN, Interval, Manual };
+    Mode mode = Mode::Immediate;
+    std::size_t every_n = 1;             // EveryN: publish on every n-th applied change
+    std::chrono::microseconds interval{0};  // Interval: publish on the first change this long after the last
+
+    static PublicationPolicy immediate() { return {}; }
+    static PublicationPolicy every(std::size_t n) { return {Mode::EveryN, n, {}}; }
+    static PublicationPolicy every(std::chrono::microseconds t) { return {Mode::Interval, 1, t}; }
+    static PublicationPolicy manual() { return {Mode::Manual, 1, {}}; }  // only flush() publishes
+};
+
+// Timing breakdown of a recompute_totals() run.
+struct TotalsRecomputeStats {
+    std::size_t elements = 0;          // elements counted into the recomputed totals
+    std::size_t replayed_changes = 0;  // writer changes logged during the scan and replayed at swap
+    std::size_t threads = 1;           // worker threads used for the scan
+    std::chrono::microseconds drain_time{0};  // waiting for writers that started before the recompute
+    std::chrono::microseconds scan_time{0};
+    std::chrono::microseconds swap_time{0};   // time writers were held off at the end
+};
+
+//==============================================================================
+// TOTAL ACCUMULATOR POLICIES
+//==============================================================================
+
+// Where atomic Add totals (detail::atomic_add_total_v) accumulate; other totals ignore this.
+
+// AtomicAccumulator: one std::atomic per total; total1()/total2() are single loads.
+struct AtomicAccumulator {};
+
+// ShardedAccumulator: Shards cache-line-padded partial sums per total, picked per writer thread,
+// so many writers stop bouncing one cache line. total1()/total2() and Var publication fold the
+// shards (O(Shards) loads).
+template <std::size_t Shards = 32>
+struct ShardedAccumulator {
+    static constexpr std::size_t shards = Shards;
+};
+
+//==============================================================================
+// GROUP-BY
+//==============================================================================
+
+// NoGrouping: GroupFn default; the collection keeps no per-group totals.
+struct NoGrouping {};
+
+namespace detail {
+// GroupFn may group by (key, elem1, elem2) or by (elem1, elem2).
+template <typename GroupFn, typename KeyT, typename E1, typename E2>
+inline constexpr bool group_by_key_v = std::is_invocable_v<const GroupFn &, const KeyT &, const E1 &, const E2 &>;
+
+template <typename GroupFn, typename KeyT, typename E1, typename E2>
+auto group_result_probe() {
+    if constexpr (std::is_same_v<GroupFn, NoGrouping>) {
+        return std::type_identity<std::monostate>{};
+    } else if constexpr (group_by_key_v<GroupFn, KeyT, E1, E2>) {
+        return std::type_identity<std::decay_t<std::invoke_result_t<const GroupFn &, const KeyT &, const E1 &, const E2 &>>>{};
+    } else {
+        return std::type_identity<std::decay_t<std::invoke_result_t<const GroupFn &, const E1 &, const E2 &>>>{};
+    }
+}
+template <typename GroupFn, typename KeyT, typename E1, typename E2>
+using group_result_t = typename decltype(group_result_probe<GroupFn, KeyT, E1, E2>())::type;
+} // namespace detail
+
+//==============================================================================
+// EXTRA AGGREGATES
+//==============================================================================
+
+// Aggregate: descriptor of an additional total, listed after TotalAccumulator. Mode folds
+// ExtractFn(elem1, elem2) of every element into TotalT (Add sums the extracted values; the other
+// modes as for total1/total2). Extra totals are maintained in the same pass, lock section and
+// reactive batch as total1/total2 and read with total<I>() / totalVar<I>() for I >= 2.
+template <typename TotalT, AggMode Mode, typename ExtractFn>
+struct Aggregate {
+    using total_type = TotalT;
+    using extract_type = ExtractFn;
+    static constexpr AggMode mode = Mode;
+};
+
+namespace detail {
+template <typename T>
+struct is_aggregate_descriptor : std::false_type {};
+template <typename TotalT, AggMode Mode, typename ExtractFn>
+struct is_aggregate_descriptor<Aggregate<TotalT, Mode, ExtractFn>> : std::true_type {};
+
+template <typename Policy, typename T>
+struct total_accumulator;
+template <typename T>
+struct total_accumulator<AtomicAccumulator, T> {
+    using type = AtomicTotal<T>;
+};
+template <std::size_t Shards, typename T>
+struct total_accumulator<ShardedAccumulator<Shards>, T> {
+    using type = ShardedTotal<T, Shards>;
+};
+template <typename Policy>
+struct is_total_accumulator_policy : std::false_type {};
+template <>
+struct is_total_accumulator_policy<AtomicAccumulator> : std::true_type {};
+template <std::size_t Shards>
+struct is_total_accumulator_policy<ShardedAccumulator<Shards>> : std::true_type {};
+
+template <typename Policy>
+struct is_sorted_block_policy : std::false_type {};
+template <std::size_t BlockSize>
+struct is_sorted_block_policy<SortedBlockOrderedIndex<BlockSize>> : std::true_type {};
+template <typename Policy>
+struct is_top_k_policy : std::false_type {};
+template <std::size_t K, std::size_t Slack>
+struct is_top_k_policy<MaintainTopK<K, Slack>> : std::true_type {};
+} // namespace detail
+
 //==============================================================================
 // MAIN CLASS - REACTIVE TWO-FIELD COLLECTION
 //==============================================================================
@@ -269,7 +1963,12 @@ template <
     bool RequireCoarseLock = false,
     bool MaintainOrderedIndex = false,
     typename CompareFn = DefaultCompare<Elem1T, Elem2T>,
-    template <typename...> class MapType = std::unordered_map
+    template <typename...> class MapType = std::unordered_map,
+    typename OrderedIndexPolicy = IdOrderedIndex,
+    bool DynamicCompare = true,
+    typename TotalAccumulator = AtomicAccumulator,
+    typename GroupFn = NoGrouping,
+    typename... ExtraAggregates
 >
 class ReactiveTwoFieldCollection {
 public:
@@ -279,16 +1978,27 @@ public:
     using total2_type = Total2T;
     using id_type = std::size_t;
     using key_type = KeyT;
+    using flow_clock = std::chrono::steady_clock;  // time base of windowed and decayed totals
+    using flow_time_point = flow_clock::time_point;
 
     using delta1_type = detail::deduced_delta_t<Total1T, Delta1Fn>;
     using delta2_type = detail::deduced_delta_t<Total2T, Delta2Fn>;
 
+    // Group of an element under GroupFn (std::monostate for NoGrouping).
+    static constexpr bool grouped = !std::is_same_v<GroupFn, NoGrouping>;
+    using group_type = detail::group_result_t<GroupFn, KeyT, Elem1T, Elem2T>;
+
     static_assert(std::is_default_constructible_v<elem1_type>, "Elem1T must be default-constructible");
     static_assert(std::is_default_constructible_v<elem2_type>, "Elem2T must be default-constructible");
 
     // runtime comparator function type (accepts elem1, elem2 pairs for two elements)
     using compare_fn_t = std::function<bool(const elem1_type&, const elem2_type&, const elem1_type&, const elem2_type&)>;
 
+    // Comparator actually stored by the collection and its index comparators. With
+    // DynamicCompare == false this is CompareFn itself, so tree comparisons inline and
+    // set_compare() is unavailable.
+    using compare_holder_type = std::conditional_t<DynamicCompare, compare_fn_t, CompareFn>;
+
     // Per-element record
     struct ElemRecord {
         reaction::Var<elem1_type> elem1Var;
@@ -297,6 +2007,7 @@ public:
         elem2_type lastElem2{};
         using key_storage_t = KeyT;  // KeyT is now always monostate or a real type
         key_storage_t key{};
+        std::uint64_t scan_gen = 0;  // last recompute_totals() scan that counted this record
 
         ElemRecord() = default;
         ElemRecord(reaction::Var<elem1_type> a, reaction::Var<elem2_type> b, key_storage_t k = key_storage_t{})
@@ -311,6 +2022,24 @@ public:
         typename ElemRecord::key_storage_t key;
     };
 
+    // (id, values) as produced by ordered iteration.
+    using ordered_entry_snapshot = std::pair<id_type, ElemRecordSnapshot>;
+
+    // Immutable copy of the ordered view published by the collection (see ordered_snapshot()).
+    // Readers keep it alive through the shared_ptr and iterate it without any lock.
+    struct OrderedSnapshot {
+        std::vector<ordered_entry_snapshot> entries;  // ascending comparator order
+        std::uint64_t version = 0;                                    // 1 for the first publication
+        std::chrono::steady_clock::time_point published_at{};
+
+        auto begin() const { return entries.cbegin(); }
+        auto end() const { return entries.cend(); }
+        std::size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        const ordered_entry_snapshot &operator[](std::size_t i) const { return entries[i]; }
+    };
+    using ordered_snapshot_ptr = std::shared_ptr<const OrderedSnapshot>;
+
     // Concurrent map type: parallel_node_hash_map preserves pointer/reference stability on rehash.
     // Uses std::mutex for native builds, phmap::NullMutex for single-threaded WASM.
 private:
@@ -335,16 +2064,33 @@ public:
     using map_type = elem_map_type;
     using iterator = typename elem_map_type::iterator;
     using const_iterator = typename elem_map_type::const_iterator;
-    using ordered_lock_ptr = std::shared_ptr<std::shared_lock<std::shared_mutex>>;
+    // Held by ordered views: the shared ordered_mtx_ lock plus, for the concurrent skip list,
+    // an epoch pin that keeps nodes unlinked by writers readable until the view is gone.
+    struct OrderedReadGuard {
+        std::shared_lock<std::shared_mutex> lock;
+        detail::EpochDomain::Guard epoch;
+    };
+    using ordered_lock_ptr = std::shared_ptr<OrderedReadGuard>;
     using lock_type = std::unique_lock<std::mutex>;
 
     // -------- Ordered-index support types (must be declared early) ----------
-    // IdComparator: calls runtime compare_fn_t on element snapshots; tie-break by id
+    // OrderedEntry: cached comparator key stored directly in the tree (CachedKeyOrderedIndex).
+    // Also the probe for value-range lookups: id 0 sorts before and the max id after every
+    // element with the same key (real ids start at 1).
+    struct OrderedEntry {
+        elem1_type elem1;
+        elem2_type elem2;
+        id_type id;
+    };
+
+    // IdComparator: calls the stored comparator on element snapshots; tie-break by id.
+    // Transparent so the id tree can be searched with an OrderedEntry probe.
     struct IdComparator {
+        using is_transparent = void;
         const ReactiveTwoFieldCollection *parent;
-        compare_fn_t cmp;
+        compare_holder_type cmp;
         IdComparator() : parent(nullptr), cmp() {}
-        IdComparator(const ReactiveTwoFieldCollection *p, compare_fn_t c) : parent(p), cmp(std::move(c)) {}
+        IdComparator(const ReactiveTwoFieldCollection *p, compare_holder_type c) : parent(p), cmp(std::move(c)) {}
         bool operator()(const id_type &a, const id_type &b) const {
             if (a == b) return false;
             // Snapshot element data via sequential if_contains (avoids nested locks on same submap)
@@ -362,8 +2108,136 @@ public:
             if (cmp(b1, b2, a1, a2)) return false;
             return a < b;
         }
+        bool operator()(const id_type &a, const OrderedEntry &probe) const {
+            bool less = a < probe.id;
+            parent->elems_.if_contains(a, [&](const auto &pair) {
+                const auto &r = pair.second;
+                if (cmp(r.lastElem1, r.lastElem2, probe.elem1, probe.elem2)) less = true;
+                else if (cmp(probe.elem1, probe.elem2, r.lastElem1, r.lastElem2)) less = false;
+            });
+            return less;
+        }
+        bool operator()(const OrderedEntry &probe, const id_type &b) const {
+            bool less = probe.id < b;
+            parent->elems_.if_contains(b, [&](const auto &pair) {
+                const auto &r = pair.second;
+                if (cmp(probe.elem1, probe.elem2, r.lastElem1, r.lastElem2)) less = true;
+                else if (cmp(r.lastElem1, r.lastElem2, probe.elem1, probe.elem2)) less = false;
+            });
+            return less;
+        }
+    };
+
+    // EntryComparator: compares cached keys only (no hash probes); tie-break by id
+    struct EntryComparator {
+        compare_holder_type cmp;
+        EntryComparator() : cmp() {}
+        explicit EntryComparator(compare_holder_type c) : cmp(std::move(c)) {}
+        bool operator()(const OrderedEntry &a, const OrderedEntry &b) const {
+            if (a.id == b.id) return false;
+            if (cmp(a.elem1, a.elem2, b.elem1, b.elem2)) return true;
+            if (cmp(b.elem1, b.elem2, a.elem1, a.elem2)) return false;
+            return a.id < b.id;
+        }
     };
-    using ordered_set_type = std::set<id_type, IdComparator>;
+
+    static constexpr bool ordered_uses_blocks = detail::is_sorted_block_policy<OrderedIndexPolicy>::value;
+    static constexpr bool ordered_top_k = detail::is_top_k_policy<OrderedIndexPolicy>::value;
+
+    static constexpr std::size_t ordered_block_size() {
+        if constexpr (ordered_uses_blocks) return OrderedIndexPolicy::block_size;
+        else return 0;
+    }
+    static constexpr std::size_t ordered_top_k_size() {
+        if constexpr (ordered_top_k) return OrderedIndexPolicy::k;
+        else return 1;
+    }
+    static constexpr std::size_t ordered_top_k_slack() {
+        if constexpr (ordered_top_k) return OrderedIndexPolicy::slack;
+        else return 0;
+    }
+
+    // Writers share ordered_mtx_ and synchronize on the index itself (per-node locks).
+    static constexpr bool ordered_concurrent = std::is_same_v<OrderedIndexPolicy, ConcurrentSkipListOrderedIndex>;
+
+    static_assert(std::is_same_v<OrderedIndexPolicy, IdOrderedIndex> ||
+                  std::is_same_v<OrderedIndexPolicy, CachedKeyOrderedIndex> || ordered_uses_blocks ||
+                  ordered_concurrent || ordered_top_k,
+                  "OrderedIndexPolicy must be IdOrderedIndex, CachedKeyOrderedIndex, SortedBlockOrderedIndex<N>, "
+                  "ConcurrentSkipListOrderedIndex or MaintainTopK<K, Slack>");
+
+    // Reactive updates and erases of different elements run concurrently when the element's submap
+    // lock is all they need: no ordered index, or the skip list. Every total tolerates updates
+    // applied out of order (additive deltas, signed Min/Max counts, signed Welford weights), so
+    // element_mtx_ then only serializes the aggregate application, and not even that when
+    // atomic_totals.
+    static constexpr bool parallel_element_updates = ordered_concurrent || !MaintainOrderedIndex;
+
+    static_assert(detail::is_total_accumulator_policy<TotalAccumulator>::value,
+                  "TotalAccumulator must be AtomicAccumulator or ShardedAccumulator<Shards>");
+    static_assert((detail::is_aggregate_descriptor<ExtraAggregates>::value && ...),
+                  "extra aggregates must be Aggregate<TotalT, Mode, ExtractFn>");
+
+    // Add totals of arithmetic deltas can also track sliding-window and decayed flows.
+    static constexpr bool flow_total1 = Total1Mode == AggMode::Add && std::is_arithmetic_v<total1_type> &&
+                                        std::is_arithmetic_v<delta1_type>;
+    static constexpr bool flow_total2 = Total2Mode == AggMode::Add && std::is_arithmetic_v<total2_type> &&
+                                        std::is_arithmetic_v<delta2_type>;
+
+    // total1/total2 plus one per Aggregate descriptor.
+    static constexpr std::size_t total_count = 2 + sizeof...(ExtraAggregates);
+    template <std::size_t I>
+    using total_type_at = std::tuple_element_t<I, std::tuple<total1_type, total2_type,
+                                                             typename ExtraAggregates::total_type...>>;
+
+    // Add totals held in TotalAccumulator storage (see detail::atomic_add_total_v); total1()/total2()
+    // then read it directly and total1Var()/total2Var() are published copies.
+    static constexpr bool atomic_total1 = detail::atomic_add_total_v<Total1Mode, Total1T, delta1_type, Apply1Fn>;
+    static constexpr bool atomic_total2 = detail::atomic_add_total_v<Total2Mode, Total2T, delta2_type, Apply2Fn>;
+    // Custom Add functors declaring lock_free_apply run in a CAS loop on a std::atomic total instead
+    // of under total1_mtx_/total2_mtx_ (see detail::cas_apply_total_v).
+    static constexpr bool cas_total1 = detail::cas_apply_total_v<Total1Mode, Total1T, delta1_type, Apply1Fn>;
+    static constexpr bool cas_total2 = detail::cas_apply_total_v<Total2Mode, Total2T, delta2_type, Apply2Fn>;
+    // Totals recompute_totals() rebuilds from element state: atomic Add totals (DefaultApplyAdd on
+    // an arithmetic total) and the Mean/Variance moments. The other modes keep exact per-value state and cannot drift.
+    static constexpr bool recompute_add1 = atomic_total1;
+    static constexpr bool recompute_add2 = atomic_total2;
+    // Totals whose Var is only a published copy, so its writes may be coalesced (PublicationPolicy).
+    static constexpr bool deferrable_total1 = atomic_total1 || cas_total1 || Total1Mode != AggMode::Add;
+    static constexpr bool deferrable_total2 = atomic_total2 || cas_total2 || Total2Mode != AggMode::Add;
+    static constexpr bool recompute_moments1 = Total1Mode == AggMode::Mean || Total1Mode == AggMode::Variance;
+    static constexpr bool recompute_moments2 = Total2Mode == AggMode::Mean || Total2Mode == AggMode::Variance;
+    static constexpr bool recomputable_totals = recompute_add1 || recompute_add2 || recompute_moments1 || recompute_moments2;
+    // Min/Max totals whose extractor is declared monotone with CompareFn
+    // (extract_monotone_with_compare) read the ordered index ends instead of keeping an extremum
+    // index. MaintainTopK only holds the greatest entries, so it can drive Max totals only.
+    static constexpr bool index_total1 =
+        MaintainOrderedIndex && detail::is_extremum_mode(Total1Mode) && extract_monotone_with_compare<Extract1Fn, CompareFn>::value &&
+        (!ordered_top_k || Total1Mode == AggMode::Max);
+    static constexpr bool index_total2 =
+        MaintainOrderedIndex && detail::is_extremum_mode(Total2Mode) && extract_monotone_with_compare<Extract2Fn, CompareFn>::value &&
+        (!ordered_top_k || Total2Mode == AggMode::Max);
+
+    // apply_pair needs no outside serialization when both totals are atomic, CAS-applied or
+    // extractor-driven (detail::extract_aggregate trackers lock themselves); combined mode has its
+    // own mutex.
+    static constexpr bool atomic_totals = (atomic_total1 || cas_total1 || Total1Mode != AggMode::Add) &&
+                                          (atomic_total2 || cas_total2 || Total2Mode != AggMode::Add);
+
+    // True when tree nodes carry their own sort keys instead of probing elems_.
+    static constexpr bool ordered_caches_keys = !std::is_same_v<OrderedIndexPolicy, IdOrderedIndex>;
+
+    using ordered_value_type = std::conditional_t<ordered_caches_keys, OrderedEntry, id_type>;
+    using ordered_comparator_type = std::conditional_t<ordered_caches_keys, EntryComparator, IdComparator>;
+    using ordered_set_type = std::conditional_t<
+        ordered_uses_blocks,
+        detail::SortedBlockSet<ordered_value_type, ordered_comparator_type, ordered_block_size()>,
+        std::conditional_t<ordered_concurrent,
+                           detail::ConcurrentSkipList<ordered_value_type, ordered_comparator_type>,
+                           std::conditional_t<ordered_top_k,
+                                              detail::TopKSet<ordered_value_type, ordered_comparator_type,
+                                                              ordered_top_k_size(), ordered_top_k_slack()>,
+                                              std::set<ordered_value_type, ordered_comparator_type>>>>;
     // -----------------------------------------------------------------------
 
     /*
@@ -378,6 +2252,10 @@ public:
                                bool coarse_lock = false)
         : total1_(reaction::var(total1_type{})),
           total2_(reaction::var(total2_type{})),
+          argtotal1_(make_argtotal_var<Total1Mode>()),
+          argtotal2_(make_argtotal_var<Total2Mode>()),
+          quantiles1_(make_quantiles_var<Total1Mode, total1_type>()),
+          quantiles2_(make_quantiles_var<Total2Mode, total2_type>()),
           delta1_(std::move(d1)), apply1_(std::move(a1)),
           delta2_(std::move(d2)), apply2_(std::move(a2)),
           extract1_(), extract2_(),
@@ -391,7 +2269,7 @@ public:
         // Phase 3: std::shared_mutex allows concurrent reads
         if constexpr (MaintainOrderedIndex) {
             std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
-            ordered_index_.emplace(IdComparator(this, cmp_));
+            ordered_index_.emplace(make_ordered_comparator());
         }
     }
 
@@ -415,20 +2293,18 @@ public:
         }
     }
 
-    // Replace the stored comparator (any callable convertible to compare_fn_t) and rebuild the ordered index atomically.
-    template <typename NewCompare>
-    void set_compare(NewCompare new_cmp) {
+    // Replace the stored comparator (any callable convertible to compare_fn_t) and rebuild the ordered index.
+    // The rebuild runs in parallel off the ordered lock (see rebuild_ordered_index()).
+    // Only available with DynamicCompare == true.
+    template <typename NewCompare, bool Dynamic = DynamicCompare>
+    std::enable_if_t<Dynamic, OrderedRebuildStats>
+    set_compare(NewCompare new_cmp) {
+        static_assert(!index_total1 && !index_total2,
+                      "set_compare() would break extract_monotone_with_compare for an index-driven Min/Max total");
         if constexpr (MaintainOrderedIndex) {
-            // Phase 3: unique_lock for write operations
-            std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
-            cmp_ = compare_fn_t(new_cmp);
-            std::optional<ordered_set_type> new_set;
-            new_set.emplace(IdComparator(this, cmp_));
-            for (typename elem_map_type::const_iterator it = elems_.begin(); it != elems_.end(); ++it) {
-                new_set->insert(it->first);
-            }
-            ordered_index_.swap(new_set);
-            // new_set (previous ordered_index_) destructs here
+            auto stats = rebuild_ordered_index_with(compare_fn_t(new_cmp), 0);
+            if (snapshots_enabled_.load(std::memory_order_acquire)) publish_ordered_snapshot();
+            return stats;
         } else {
             // No ordered index: keep coarse-lock policy unchanged for compatibility.
             if constexpr (RequireCoarseLock) {
@@ -442,21 +2318,166 @@ public:
                     cmp_ = compare_fn_t(new_cmp);
                 }
             }
+            return OrderedRebuildStats{};
         }
     }
 
-    // Rebuild the ordered index using the current runtime comparator (cmp_).
+    // Rebuild the ordered index using the current comparator.
     // Useful when element state was bulk-updated or comparator semantics are unchanged.
-    void rebuild_ordered_index() {
-        if constexpr (!MaintainOrderedIndex) return;
-        // Phase 3: unique_lock for write operations
-        std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
-        std::optional<ordered_set_type> new_set;
-        new_set.emplace(IdComparator(this, cmp_));
-        for (typename elem_map_type::const_iterator it = elems_.begin(); it != elems_.end(); ++it) {
-            new_set->insert(it->first);
+    // Snapshots (lastElem1, lastElem2, id) from the elems_ submaps and sorts them on `threads`
+    // workers (0 = hardware concurrency), then bulk-loads the new index in O(n). Cached-key
+    // backends do all of that without holding ordered_mtx_; writer changes made meanwhile are
+    // logged and replayed onto the new index in the short exclusive section that swaps it in.
+    OrderedRebuildStats rebuild_ordered_index(std::size_t threads = 0) {
+        if constexpr (!MaintainOrderedIndex) return OrderedRebuildStats{};
+        auto stats = rebuild_ordered_index_with(std::nullopt, threads);
+        if (snapshots_enabled_.load(std::memory_order_acquire)) publish_ordered_snapshot();
+        return stats;
+    }
+
+    [[nodiscard]] OrderedRebuildStats last_rebuild_stats() const {
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        return last_rebuild_stats_;
+    }
+
+    // Cadence at which total, extra and group Vars are written (see PublicationPolicy); switching
+    // publishes the current totals. Throws std::invalid_argument for EveryN with n == 0 or a
+    // non-positive Interval.
+    void set_publication_policy(const PublicationPolicy &policy) {
+        if (policy.mode == PublicationPolicy::Mode::EveryN && policy.every_n == 0)
+            throw std::invalid_argument("set_publication_policy: every_n must be positive");
+        if (policy.mode == PublicationPolicy::Mode::Interval && policy.interval.count() <= 0)
+            throw std::invalid_argument("set_publication_policy: interval must be positive");
+        publish_every_n_.store(policy.every_n);
+        publish_interval_us_.store(policy.interval.count());
+        publish_mode_.store(policy.mode);
+        flush();
+    }
+    [[nodiscard]] PublicationPolicy publication_policy() const {
+        return {publish_mode_.load(), publish_every_n_.load(), std::chrono::microseconds(publish_interval_us_.load())};
+    }
+
+    // Write the current totals, extra totals and group totals to their Vars now (e.g. from a frame
+    // tick), whatever the policy. Vars already holding the current value are left alone.
+    void flush() {
+        publish_pending_.store(0);
+        publish_last_us_.store(snapshot_clock_us());
+        auto write = [this] {
+            if constexpr (deferrable_total1) {
+                total1_publisher_.publish_changes([this] { return load_total1(); }, total1_);
+                if constexpr (detail::is_extremum_mode(Total1Mode))
+                    argtotal1_publisher_.publish_changes([this] { return load_argtotal1(); }, argtotal1_);
+                if constexpr (Total1Mode == AggMode::Quantile)
+                    quantiles1_publisher_.publish_changes([this] { return idx1_.values(); }, quantiles1_);
+            }
+            if constexpr (deferrable_total2) {
+                total2_publisher_.publish_changes([this] { return load_total2(); }, total2_);
+                if constexpr (detail::is_extremum_mode(Total2Mode))
+                    argtotal2_publisher_.publish_changes([this] { return load_argtotal2(); }, argtotal2_);
+                if constexpr (Total2Mode == AggMode::Quantile)
+                    quantiles2_publisher_.publish_changes([this] { return idx2_.values(); }, quantiles2_);
+            }
+            if constexpr (sizeof...(ExtraAggregates) > 0) publish_extras();
+            publish_all_groups();
+        };
+        if (combined_atomic_) {
+            std::lock_guard<std::mutex> g(combined_mtx_);
+            reaction::batchExecute(write);
+        } else {
+            write();
+        }
+    }
+
+    // Rebuild the drift-prone totals from element state: atomic Add totals (DefaultApplyAdd on an
+    // arithmetic total) become the sum of each element's push delta (delta(lastElem1, lastElem2, {}, {})), and
+    // Mean/Variance moments are recomputed from the extractor values. The elems_ submaps are
+    // scanned on `threads` workers (0 = hardware concurrency) while writers keep running; their
+    // changes to already-counted elements are logged and replayed onto the fresh totals in the
+    // short section that swaps them in, the only time ingest waits. Extra aggregates, group and
+    // windowed totals are left as they are. It waits for in-flight writes to finish, so calling it
+    // from inside one (an observer of this collection's Vars) throws std::logic_error.
+    template <bool B = recomputable_totals>
+    std::enable_if_t<B, TotalsRecomputeStats> recompute_totals(std::size_t threads = 0) {
+        const auto &held = gates_held();
+        if (std::find(held.begin(), held.end(), this) != held.end())
+            throw std::logic_error("recompute_totals: called from inside a write to this collection");
+        using clock = std::chrono::steady_clock;
+        auto since = [](clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+        };
+        auto &state = recompute_;
+        std::lock_guard<std::mutex> guard(state.mtx);
+        TotalsRecomputeStats stats;
+        stats.threads = detail::worker_count(threads);
+        const std::uint64_t gen = state.gen.fetch_add(1) + 1;
+
+        // If a functor or an allocation throws mid-way, put writers back on the unlogged path and
+        // drop the scan state, so the log cannot grow without bound.
+        struct AbortGuard {
+            RecomputeState &state;
+            bool done = false;
+            ~AbortGuard() {
+                if (done) return;
+                std::unique_lock<std::shared_mutex> swap(state.swap_mtx);
+                state.log.clear();
+                for (auto &flag : state.scanned) flag.store(false);
+                state.active.store(false);
+            }
+        } abort_guard{state};
+
+        // From here on writers take the logged path; wait out the ones that started before.
+        auto phase = clock::now();
+        state.active.store(true);
+        for (auto &slot : state.inflight) {
+            while (slot.writers.load() != 0) std::this_thread::yield();
+        }
+        stats.drain_time = since(phase);
+
+        phase = clock::now();
+        const std::size_t submaps = elems_.subcnt();
+        const std::size_t workers = std::max<std::size_t>(1, std::min(stats.threads, submaps));
+        std::vector<RecomputePartial> parts(workers);
+        detail::run_parallel(workers, [&](std::size_t t) {
+            for (std::size_t i = t; i < submaps; i += workers) {
+                elems_.with_submap_m(i, [&](auto &submap) {
+                    for (auto &pair : submap) {
+                        pair.second.scan_gen = gen;
+                        count_for_recompute(parts[t], pair.second.lastElem1, pair.second.lastElem2);
+                    }
+                    state.scanned[i].store(true);
+                });
+            }
+        });
+        RecomputePartial fresh;
+        for (const auto &part : parts) fresh.merge(part);
+        stats.scan_time = since(phase);
+
+        {
+            std::unique_lock<std::shared_mutex> swap(state.swap_mtx);
+            const auto locked_at = clock::now();
+            install_recomputed_totals(fresh, state.log);
+            stats.elements = fresh.elements;
+            stats.replayed_changes = state.log.size();
+            state.log.clear();
+            for (auto &flag : state.scanned) flag.store(false);
+            state.active.store(false);
+            abort_guard.done = true;
+            stats.swap_time = since(locked_at);
+        }
+        // Publish outside the swap so observers may write to the collection.
+        auto write = [this] {
+            if constexpr (recompute_add1 || recompute_moments1)
+                total1_publisher_.publish_changes([this] { return load_total1(); }, total1_);
+            if constexpr (recompute_add2 || recompute_moments2)
+                total2_publisher_.publish_changes([this] { return load_total2(); }, total2_);
+        };
+        if (combined_atomic_) {
+            std::lock_guard<std::mutex> g(combined_mtx_);
+            reaction::batchExecute(write);
+        } else {
+            write();
         }
-        ordered_index_.swap(new_set);
+        return stats;
     }
 
     // Acquire coarse-grained lock (owns the lock only if coarse locking active)
@@ -480,7 +2501,9 @@ public:
         return push_one(e1, e2, std::move(key));
     }
 
-    // batch push
+    // batch push: ids are one contiguous range, records are built per elems_ submap on worker
+    // threads, the ordered index takes one lock acquisition and the aggregates one folded
+    // apply_pair (see push_bulk()).
     void push_back(const std::vector<std::pair<elem1_type, elem2_type>> &vals, const std::vector<key_type> *keys = nullptr) {
         auto lk = maybe_lock();
         if (vals.empty()) return;
@@ -514,70 +2537,74 @@ public:
             }
         }
 
-        reaction::batchExecute([this, &vals, keys]() {
-            for (size_t i = 0; i < vals.size(); ++i) {
-                if constexpr (std::is_same_v<KeyT, std::monostate>) {
-                    (void)push_one_no_batch(vals[i].first, vals[i].second, typename ElemRecord::key_storage_t{});
-                } else {
-                    typename ElemRecord::key_storage_t k = (keys && i < keys->size()) ? (*keys)[i] : typename ElemRecord::key_storage_t{};
-                    (void)push_one_no_batch(vals[i].first, vals[i].second, std::move(k));
-                }
-            }
-        });
+        reaction::batchExecute([this, &vals, keys]() { push_bulk(vals, keys); });
     }
 
     // erase by id
     void erase(id_type id) {
-        auto lk = maybe_lock();
-        std::lock_guard<std::recursive_mutex> element_guard(element_mtx_);
+        auto lk = maybe_lock();  // before the gate: recompute_totals() may run under lock_public()
+        RecomputeGate gate(*this);
+        std::unique_lock<std::recursive_mutex> element_guard(element_mtx_, std::defer_lock);
+        if constexpr (!parallel_element_updates) element_guard.lock();
 
-        // Snapshot element data via if_contains
-        std::optional<total1_type> old_ext1;
-        std::optional<total2_type> old_ext2;
-        delta1_type rem1{};
-        delta2_type rem2{};
-        typename ElemRecord::key_storage_t key_to_erase{};
-        bool found = false;
-        auto snapshot = [&](const auto &pair) {
-            const ElemRecord &rec = pair.second;
-            if constexpr (Total1Mode != AggMode::Add) old_ext1 = extract1_(rec.lastElem1, rec.lastElem2);
-            if constexpr (Total2Mode != AggMode::Add) old_ext2 = extract2_(rec.lastElem1, rec.lastElem2);
-            rem1 = delta1_(elem1_type{}, elem2_type{}, rec.lastElem1, rec.lastElem2);
-            rem2 = delta2_(elem1_type{}, elem2_type{}, rec.lastElem1, rec.lastElem2);
-            if constexpr (!std::is_same_v<KeyT, std::monostate>) {
-                key_to_erase = rec.key;
-            }
-            found = true;
-        };
+        std::optional<ErasedRecord> erased;
+        with_ordered_write_lock([&] { erased = take_record_locked(id, gate); });
+        if (!erased) return;
+        note_ordered_change();
 
-        if constexpr (MaintainOrderedIndex) {
-            // Keep comparator-visible element state stable until the id leaves the tree.
-            std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
-            elems_.if_contains(id, snapshot);
-            if (found && ordered_index_) {
-                ordered_index_->erase(id);
-            }
-        } else {
-            elems_.if_contains(id, snapshot);
+        if constexpr (!std::is_same_v<KeyT, std::monostate>) {
+            key_index_.erase(erased->key);
         }
-        if (!found) return;
 
-        if constexpr (!std::is_same_v<KeyT, std::monostate>) {
-            key_index_.erase(key_to_erase);
+        // Erase monitor: close action inside erase_if callback
+        monitors_.erase_if(id, [](auto &pair) { pair.second.close(); return true; });
+        
+        // Only the thread that actually removed the record (found) updates counters and totals.
+        elem_count_.fetch_sub(1, std::memory_order_relaxed);
+
+        if constexpr (!atomic_totals) {
+            if (!element_guard.owns_lock()) element_guard.lock();
+        }
+        apply_erased(*erased);
+        if (element_guard.owns_lock()) element_guard.unlock();
+        maybe_publish_ordered_snapshot();
+    }
+
+    // bulk erase: the ordered index takes one lock acquisition for all ids, and the removal deltas
+    // fold into one apply_pair (see apply_erase_bulk()). Unknown and repeated ids are skipped;
+    // returns the number of elements removed.
+    std::size_t erase(std::span<const id_type> ids) {
+        auto lk = maybe_lock();  // before the gate: recompute_totals() may run under lock_public()
+        RecomputeGate gate(*this);
+        std::unique_lock<std::recursive_mutex> element_guard(element_mtx_, std::defer_lock);
+        if constexpr (!parallel_element_updates) element_guard.lock();
+
+        std::vector<ErasedRecord> erased;
+        erased.reserve(ids.size());
+        with_ordered_write_lock([&] {
+            for (id_type id : ids) {
+                if (auto rec = take_record_locked(id, gate)) erased.push_back(std::move(*rec));
+            }
+        });
+        if (erased.empty()) return 0;
+        note_ordered_change(erased.size());
+
+        for (const auto &rec : erased) {
+            if constexpr (has_keys) key_index_.erase(rec.key);
+            monitors_.erase_if(rec.id, [](auto &pair) { pair.second.close(); return true; });
         }
+        elem_count_.fetch_sub(erased.size(), std::memory_order_relaxed);
 
-        // Erase monitor: close action inside erase_if callback
-        monitors_.erase_if(id, [](auto &pair) { pair.second.close(); return true; });
-        
-        // Only the thread that actually removes the record updates counters and totals.
-        if (elems_.erase(id) == 0) return;
-        elem_count_.fetch_sub(1, std::memory_order_relaxed);
-
-        apply_pair(rem1, rem2,
-                   /*have_old1*/ bool(old_ext1), old_ext1 ? &*old_ext1 : nullptr,
-                   /*have_new1*/ false, nullptr,
-                   /*have_old2*/ bool(old_ext2), old_ext2 ? &*old_ext2 : nullptr,
-                   /*have_new2*/ false, nullptr);
+        if constexpr (!atomic_totals) {
+            if (!element_guard.owns_lock()) element_guard.lock();
+        }
+        reaction::batchExecute([this, &erased]() { apply_erase_bulk(erased); });
+        if (element_guard.owns_lock()) element_guard.unlock();
+        maybe_publish_ordered_snapshot();
+        return erased.size();
+    }
+    std::size_t erase(std::initializer_list<id_type> ids) {
+        return erase(std::span<const id_type>(ids.begin(), ids.size()));
     }
 
     // erase by key (enabled if KeyT != void)
@@ -592,6 +2619,23 @@ public:
         if (found) erase(found_id);
     }
 
+    // bulk erase by key (enabled if KeyT != void); keys without an element are skipped.
+    template <typename K = KeyT>
+    std::enable_if_t<!std::is_same_v<K, std::monostate>, std::size_t>
+    erase_by_keys(std::span<const std::type_identity_t<K>> keys) {
+        std::vector<id_type> ids;
+        ids.reserve(keys.size());
+        for (const auto &k : keys) {
+            key_index_.if_contains(k, [&](const auto &pair) { ids.push_back(pair.second); });
+        }
+        return erase(std::span<const id_type>(ids));
+    }
+    template <typename K = KeyT>
+    std::enable_if_t<!std::is_same_v<K, std::monostate>, std::size_t>
+    erase_by_keys(std::initializer_list<std::type_identity_t<K>> keys) {
+        return erase_by_keys<K>(std::span<const K>(keys.begin(), keys.size()));
+    }
+
     // find_by_key (fast) - enabled if KeyT != void
     template <typename K = KeyT>
     [[nodiscard]] std::enable_if_t<!std::is_same_v<K, std::monostate>, std::optional<id_type>>
@@ -631,38 +2675,239 @@ public:
         throw std::out_of_range("elem2Var: id not found");
     }
 
-    // totals - optimized: when coarse lock not enabled, direct read (reaction::Var handles thread-safety)
+    // totals - optimized: when coarse lock not enabled, direct read (atomic for Add totals, else reaction::Var)
     [[nodiscard]] total1_type total1() const {
         if constexpr (RequireCoarseLock) {
             std::lock_guard<std::mutex> g(coarse_mtx_);
-            return total1_.get();
+            return load_total1();
         } else {
             if (coarse_lock_enabled_) {
                 std::lock_guard<std::mutex> g(coarse_mtx_);
-                return total1_.get();
+                return load_total1();
             } else {
-                // Lock-free fast path - reaction::Var is thread-safe
-                return total1_.get();
+                // Lock-free fast path - atomic load or thread-safe reaction::Var
+                return load_total1();
             }
         }
     }
     [[nodiscard]] total2_type total2() const {
         if constexpr (RequireCoarseLock) {
             std::lock_guard<std::mutex> g(coarse_mtx_);
-            return total2_.get();
+            return load_total2();
         } else {
             if (coarse_lock_enabled_) {
                 std::lock_guard<std::mutex> g(coarse_mtx_);
-                return total2_.get();
+                return load_total2();
             } else {
-                // Lock-free fast path - reaction::Var is thread-safe
-                return total2_.get();
+                // Lock-free fast path - atomic load or thread-safe reaction::Var
+                return load_total2();
             }
         }
     }
+    // Reactive totals. For atomic Add totals these are published after each change and may
+    // briefly trail total1()/total2() while another writer is publishing.
     [[nodiscard]] reaction::Var<total1_type> &total1Var() { return total1_; }
     [[nodiscard]] reaction::Var<total2_type> &total2Var() { return total2_; }
 
+    // Total I: total1() / total2() for I = 0 / 1, then the extra Aggregate descriptors in order.
+    template <std::size_t I>
+    [[nodiscard]] total_type_at<I> total() const {
+        static_assert(I < total_count, "total<I>: no such aggregate");
+        if constexpr (I == 0) return total1();
+        else if constexpr (I == 1) return total2();
+        else {
+            auto lk = maybe_lock();
+            return std::get<I - 2>(extras_).tracker.load();
+        }
+    }
+    template <std::size_t I>
+    [[nodiscard]] reaction::Var<total_type_at<I>> &totalVar() {
+        static_assert(I < total_count, "totalVar<I>: no such aggregate");
+        if constexpr (I == 0) return total1_;
+        else if constexpr (I == 1) return total2_;
+        else return std::get<I - 2>(extras_).var;
+    }
+
+    // Min/Max modes: id of an element holding total1()/total2() (smallest id among equal values,
+    // or the index end when the ordered index drives the total); nullopt when empty. The Vars
+    // hold the same id (0 when empty) and change only when the holder changes.
+    template <AggMode M = Total1Mode>
+    [[nodiscard]] std::enable_if_t<detail::is_extremum_mode(M), std::optional<id_type>> argtotal1() const {
+        auto entry = top_entry1();
+        if (!entry) return std::nullopt;
+        return entry->second;
+    }
+    template <AggMode M = Total2Mode>
+    [[nodiscard]] std::enable_if_t<detail::is_extremum_mode(M), std::optional<id_type>> argtotal2() const {
+        auto entry = top_entry2();
+        if (!entry) return std::nullopt;
+        return entry->second;
+    }
+    template <AggMode M = Total1Mode>
+    [[nodiscard]] std::enable_if_t<detail::is_extremum_mode(M), reaction::Var<id_type> &> argtotal1Var() { return argtotal1_; }
+    template <AggMode M = Total2Mode>
+    [[nodiscard]] std::enable_if_t<detail::is_extremum_mode(M), reaction::Var<id_type> &> argtotal2Var() { return argtotal2_; }
+
+    // Quantile modes: any q-quantile of the extractor values in O(log n) (linear interpolation
+    // between neighbouring order statistics; T{} when empty). total1()/total2() report the first
+    // configured quantile and quantiles1Var()/quantiles2Var() all of them, in order; the median
+    // is configured by default. set_quantiles throws std::invalid_argument for an empty list or a
+    // q outside [0, 1].
+    template <AggMode M = Total1Mode>
+    [[nodiscard]] std::enable_if_t<M == AggMode::Quantile, total1_type> quantile1(double q) const {
+        return idx1_.quantile(q);
+    }
+    template <AggMode M = Total2Mode>
+    [[nodiscard]] std::enable_if_t<M == AggMode::Quantile, total2_type> quantile2(double q) const {
+        return idx2_.quantile(q);
+    }
+    template <AggMode M = Total1Mode>
+    [[nodiscard]] std::enable_if_t<M == AggMode::Quantile, reaction::Var<std::vector<total1_type>> &> quantiles1Var() {
+        return quantiles1_;
+    }
+    template <AggMode M = Total2Mode>
+    [[nodiscard]] std::enable_if_t<M == AggMode::Quantile, reaction::Var<std::vector<total2_type>> &> quantiles2Var() {
+        return quantiles2_;
+    }
+    template <AggMode M = Total1Mode>
+    std::enable_if_t<M == AggMode::Quantile> set_quantiles1(std::vector<double> qs) {
+        idx1_.set_quantiles(std::move(qs));
+        republish_quantiles<1>();
+    }
+    template <AggMode M = Total2Mode>
+    std::enable_if_t<M == AggMode::Quantile> set_quantiles2(std::vector<double> qs) {
+        idx2_.set_quantiles(std::move(qs));
+        republish_quantiles<2>();
+    }
+
+    // Windowed and decayed Add totals (arithmetic deltas): every delta passing through the totals
+    // is also summed over the last `window` (a ring of `slices` time slices, so the window edge is
+    // accurate to window / slices) and into an exponentially decayed total that halves every
+    // half_life. Both are off until enabled; enabling again restarts from zero. The Vars are
+    // refreshed by writes and by advance_flows(), which a UI or timer calls so expiry and decay
+    // show without new deltas. Invalid durations throw std::invalid_argument.
+    template <bool F = flow_total1>
+    std::enable_if_t<F> enable_window1(std::chrono::nanoseconds window, std::size_t slices = 64) {
+        flows1_.window.configure(window, slices);
+        flows1_.publish();
+    }
+    template <bool F = flow_total2>
+    std::enable_if_t<F> enable_window2(std::chrono::nanoseconds window, std::size_t slices = 64) {
+        flows2_.window.configure(window, slices);
+        flows2_.publish();
+    }
+    template <bool F = flow_total1>
+    std::enable_if_t<F> enable_decay1(std::chrono::nanoseconds half_life) {
+        flows1_.decay.configure(half_life);
+        flows1_.publish();
+    }
+    template <bool F = flow_total2>
+    std::enable_if_t<F> enable_decay2(std::chrono::nanoseconds half_life) {
+        flows2_.decay.configure(half_life);
+        flows2_.publish();
+    }
+    template <bool F = flow_total1>
+    [[nodiscard]] std::enable_if_t<F, total1_type> window_total1(flow_time_point now = flow_clock::now()) {
+        return flows1_.window.load(now);
+    }
+    template <bool F = flow_total2>
+    [[nodiscard]] std::enable_if_t<F, total2_type> window_total2(flow_time_point now = flow_clock::now()) {
+        return flows2_.window.load(now);
+    }
+    template <bool F = flow_total1>
+    [[nodiscard]] std::enable_if_t<F, double> decayed_total1(flow_time_point now = flow_clock::now()) {
+        return flows1_.decay.load(now);
+    }
+    template <bool F = flow_total2>
+    [[nodiscard]] std::enable_if_t<F, double> decayed_total2(flow_time_point now = flow_clock::now()) {
+        return flows2_.decay.load(now);
+    }
+    template <bool F = flow_total1>
+    [[nodiscard]] std::enable_if_t<F, reaction::Var<total1_type> &> windowTotal1Var() { return flows1_.window_var; }
+    template <bool F = flow_total2>
+    [[nodiscard]] std::enable_if_t<F, reaction::Var<total2_type> &> windowTotal2Var() { return flows2_.window_var; }
+    template <bool F = flow_total1>
+    [[nodiscard]] std::enable_if_t<F, reaction::Var<double> &> decayedTotal1Var() { return flows1_.decay_var; }
+    template <bool F = flow_total2>
+    [[nodiscard]] std::enable_if_t<F, reaction::Var<double> &> decayedTotal2Var() { return flows2_.decay_var; }
+    // Expires window slices and applies decay up to now, then writes the changed Vars. Flows never
+    // move back in time, so an earlier `now` than the last one seen changes nothing.
+    void advance_flows(flow_time_point now = flow_clock::now()) {
+        if constexpr (flow_total1 || flow_total2) {
+            if (combined_atomic_) {
+                std::lock_guard<std::mutex> g(combined_mtx_);
+                reaction::batchExecute([this, now] { publish_flows(now); });
+            } else {
+                publish_flows(now);
+            }
+        }
+    }
+
+    // Group-by (GroupFn != NoGrouping): total1/total2 per group of GroupFn(key, elem1, elem2) or
+    // GroupFn(elem1, elem2), maintained in the same apply_pair pass as the collection totals (and
+    // in combined mode published in the same batch). An element whose group changes moves between
+    // groups. Groups are created on first use and kept, with their Vars, until
+    // prune_empty_groups(); groupTotal1Var() creates the group so it can be observed before it
+    // fills.
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, std::optional<total1_type>> group_total1(const group_type &g) const {
+        std::optional<total1_type> out;
+        groups_.if_contains(g, [&](const auto &pair) { out = pair.second->load1(); });
+        return out;
+    }
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, std::optional<total2_type>> group_total2(const group_type &g) const {
+        std::optional<total2_type> out;
+        groups_.if_contains(g, [&](const auto &pair) { out = pair.second->load2(); });
+        return out;
+    }
+    // Elements currently in group g.
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, std::size_t> group_size(const group_type &g) const {
+        std::size_t n = 0;
+        groups_.if_contains(g, [&](const auto &pair) {
+            std::lock_guard<std::mutex> lk(pair.second->mtx);
+            n = pair.second->count > 0 ? static_cast<std::size_t>(pair.second->count) : 0;
+        });
+        return n;
+    }
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, reaction::Var<total1_type>> groupTotal1Var(const group_type &g) {
+        return with_group(g, [](GroupState &) {})->var1;
+    }
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, reaction::Var<total2_type>> groupTotal2Var(const group_type &g) {
+        return with_group(g, [](GroupState &) {})->var2;
+    }
+    // The n groups with the largest total1()/total2() (descending). O(groups + n log n).
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, std::vector<std::pair<group_type, total1_type>>> top_groups1(std::size_t n) const {
+        return top_groups_by(n, [](const GroupState &st) { return st.load1(); });
+    }
+    template <bool G = grouped>
+    [[nodiscard]] std::enable_if_t<G, std::vector<std::pair<group_type, total2_type>>> top_groups2(std::size_t n) const {
+        return top_groups_by(n, [](const GroupState &st) { return st.load2(); });
+    }
+    // Drops groups without elements; returns how many. Their Vars stop updating, and a group that
+    // fills again starts with fresh Vars.
+    template <bool G = grouped>
+    std::enable_if_t<G, std::size_t> prune_empty_groups() {
+        std::vector<group_type> empty;
+        groups_.for_each([&](const auto &pair) {
+            std::lock_guard<std::mutex> lk(pair.second->mtx);
+            if (pair.second->count == 0) empty.push_back(pair.first);
+        });
+        std::size_t pruned = 0;
+        for (const auto &g : empty) {
+            const bool erased = groups_.erase_if(g, [](const auto &pair) {
+                std::lock_guard<std::mutex> lk(pair.second->mtx);
+                return pair.second->count == 0;
+            });
+            if (erased) ++pruned;
+        }
+        return pruned;
+    }
+
     // size / empty - lock-free using atomic counter
     [[nodiscard]] size_t size() const noexcept {
         return elem_count_.load(std::memory_order_relaxed);
@@ -711,12 +2956,7 @@ public:
         bool operator!=(const OrderedConstIterator &o) const { return !(*this == o); }
 
         std::pair<id_type, ElemRecordSnapshot> operator*() const {
-            id_type id = *it_;
-            ElemRecordSnapshot snap{};
-            parent_->elems_.if_contains(id, [&](const auto &pair) {
-                snap = {pair.second.lastElem1, pair.second.lastElem2, pair.second.key};
-            });
-            return { id, snap };
+            return parent_->ordered_deref(*it_);
         }
     };
 
@@ -741,12 +2981,7 @@ public:
         bool operator!=(const OrderedIterator &o) const { return !(*this == o); }
 
         std::pair<id_type, ElemRecordSnapshot> operator*() const {
-            id_type id = *it_;
-            ElemRecordSnapshot snap{};
-            parent_->elems_.if_contains(id, [&](const auto &pair) {
-                snap = {pair.second.lastElem1, pair.second.lastElem2, pair.second.key};
-            });
-            return { id, snap };
+            return parent_->ordered_deref(*it_);
         }
     };
 
@@ -771,12 +3006,7 @@ public:
         bool operator!=(const OrderedConstReverseIterator &o) const { return !(*this == o); }
 
         std::pair<id_type, ElemRecordSnapshot> operator*() const {
-            id_type id = *it_;
-            ElemRecordSnapshot snap{};
-            parent_->elems_.if_contains(id, [&](const auto &pair) {
-                snap = {pair.second.lastElem1, pair.second.lastElem2, pair.second.key};
-            });
-            return { id, snap };
+            return parent_->ordered_deref(*it_);
         }
     };
 
@@ -800,12 +3030,7 @@ public:
         bool operator!=(const OrderedReverseIterator &o) const { return !(*this == o); }
 
         std::pair<id_type, ElemRecordSnapshot> operator*() const {
-            id_type id = *it_;
-            ElemRecordSnapshot snap{};
-            parent_->elems_.if_contains(id, [&](const auto &pair) {
-                snap = {pair.second.lastElem1, pair.second.lastElem2, pair.second.key};
-            });
-            return { id, snap };
+            return parent_->ordered_deref(*it_);
         }
     };
 
@@ -856,41 +3081,679 @@ public:
         OrderedReverseIterator rend() const { return OrderedReverseIterator(parent_, rend_, lock_); }
     };
 
-    [[nodiscard]] OrderedConstRange ordered() const {
-        if constexpr (!MaintainOrderedIndex) return OrderedConstRange();
-        auto lock = std::make_shared<std::shared_lock<std::shared_mutex>>(ordered_mtx_);
-        if (!ordered_index_) return OrderedConstRange();
-        return OrderedConstRange(this, ordered_index_->cbegin(), ordered_index_->cend(),
-                                 ordered_index_->crbegin(), ordered_index_->crend(), lock);
+    [[nodiscard]] OrderedConstRange ordered() const {
+        if constexpr (!MaintainOrderedIndex) return OrderedConstRange();
+        auto lock = make_ordered_read_guard();
+        if (!ordered_index_) return OrderedConstRange();
+        return OrderedConstRange(this, ordered_index_->cbegin(), ordered_index_->cend(),
+                                 ordered_index_->crbegin(), ordered_index_->crend(), lock);
+    }
+
+    [[nodiscard]] OrderedRange ordered() {
+        if constexpr (!MaintainOrderedIndex) return OrderedRange();
+        auto lock = make_ordered_read_guard();
+        if (!ordered_index_) return OrderedRange();
+        return OrderedRange(this, ordered_index_->begin(), ordered_index_->end(),
+                            ordered_index_->rbegin(), ordered_index_->rend(), lock);
+    }
+
+    // top_k / bottom_k helpers (ids)
+    [[nodiscard]] std::vector<id_type> top_k(size_t k) const {
+        std::vector<id_type> out;
+        if constexpr (!MaintainOrderedIndex) return out;
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_) return out;
+        auto epoch = ordered_epoch_pin();
+        for (auto it = ordered_index_->rbegin(); it != ordered_index_->rend() && out.size() < k; ++it) out.push_back(ordered_id(*it));
+        return out;
+    }
+    [[nodiscard]] std::vector<id_type> bottom_k(size_t k) const {
+        std::vector<id_type> out;
+        if constexpr (!MaintainOrderedIndex) return out;
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_) return out;
+        auto epoch = ordered_epoch_pin();
+        for (auto it = ordered_index_->begin(); it != ordered_index_->end() && out.size() < k; ++it) out.push_back(ordered_id(*it));
+        return out;
+    }
+
+    // top_k / bottom_k with values: ids and element snapshots copied in one pass under one
+    // ordered lock, so the result is never torn. The overloads taking `out` clear and refill it,
+    // reusing its capacity (no allocation once warmed up, e.g. per rendered frame).
+    [[nodiscard]] std::vector<ordered_entry_snapshot> top_k_snapshots(size_t k) const {
+        std::vector<ordered_entry_snapshot> out;
+        top_k_snapshots(k, out);
+        return out;
+    }
+    void top_k_snapshots(size_t k, std::vector<ordered_entry_snapshot> &out) const {
+        out.clear();
+        if constexpr (!MaintainOrderedIndex) return;
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_) return;
+        auto epoch = ordered_epoch_pin();
+        out.reserve(std::min(k, ordered_index_->size()));
+        for (auto it = ordered_index_->rbegin(); it != ordered_index_->rend() && out.size() < k; ++it) out.push_back(ordered_deref(*it));
+    }
+    [[nodiscard]] std::vector<ordered_entry_snapshot> bottom_k_snapshots(size_t k) const {
+        std::vector<ordered_entry_snapshot> out;
+        bottom_k_snapshots(k, out);
+        return out;
+    }
+    void bottom_k_snapshots(size_t k, std::vector<ordered_entry_snapshot> &out) const {
+        out.clear();
+        if constexpr (!MaintainOrderedIndex) return;
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_) return;
+        auto epoch = ordered_epoch_pin();
+        out.reserve(std::min(k, ordered_index_->size()));
+        for (auto it = ordered_index_->begin(); it != ordered_index_->end() && out.size() < k; ++it) out.push_back(ordered_deref(*it));
+    }
+
+    // Order statistics over the ordered index (ascending comparator order, zero-based).
+    // O(log n) with SortedBlockOrderedIndex (Fenwick tree over block sizes); the std::set and
+    // skip-list backends fall back to walking the index.
+    [[nodiscard]] std::optional<size_t> rank(id_type id) const {
+        if constexpr (!MaintainOrderedIndex) return std::nullopt;
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_) return std::nullopt;
+        auto epoch = ordered_epoch_pin();
+        auto probe = ordered_probe(id);
+        if (!probe) return std::nullopt;
+        auto it = ordered_index_->find(*probe);
+        if (it == ordered_index_->end()) return std::nullopt;
+        return ordered_rank_locked(it);
+    }
+
+    [[nodiscard]] std::optional<id_type> select(size_t k) const {
+        if constexpr (!MaintainOrderedIndex) return std::nullopt;
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_) return std::nullopt;
+        auto epoch = ordered_epoch_pin();
+        auto it = ordered_select_locked(k);
+        if (it == ordered_index_->cend()) return std::nullopt;
+        return ordered_id(*it);
+    }
+
+    // Lock-owning view of ranks [offset, offset + limit), e.g. one page of a virtualized table.
+    [[nodiscard]] OrderedConstRange ordered_page(size_t offset, size_t limit) const {
+        if constexpr (!MaintainOrderedIndex) return OrderedConstRange();
+        auto lock = make_ordered_read_guard();
+        if (!ordered_index_) return OrderedConstRange();
+        const size_t n = ordered_index_->size();
+        const size_t first = std::min(offset, n);
+        auto b = ordered_select_locked(first);
+        auto e = ordered_select_locked(first + std::min(limit, n - first));
+        return OrderedConstRange(this, b, e, ordered_underlying_const_rit(e), ordered_underlying_const_rit(b), lock);
+    }
+
+    // Lock-owning value-range views, positioned in O(log n) (plus the comparator's hash probes
+    // with IdOrderedIndex). Bounds are (elem1, elem2) keys in comparator order; e.g. with the
+    // default lexicographic comparator, ordered_between({a, lowest}, {b, lowest}) is elem1 in [a, b).
+    // ordered_lower_bound: first element whose key is not before (e1, e2), to the end.
+    [[nodiscard]] OrderedConstRange ordered_lower_bound(const elem1_type &e1, const elem2_type &e2) const {
+        if constexpr (!MaintainOrderedIndex) return OrderedConstRange();
+        auto lock = make_ordered_read_guard();
+        if (!ordered_index_) return OrderedConstRange();
+        return ordered_range_locked(ordered_bound_locked(e1, e2, false), ordered_index_->cend(), lock);
+    }
+
+    // ordered_upper_bound: first element whose key is after (e1, e2), to the end.
+    [[nodiscard]] OrderedConstRange ordered_upper_bound(const elem1_type &e1, const elem2_type &e2) const {
+        if constexpr (!MaintainOrderedIndex) return OrderedConstRange();
+        auto lock = make_ordered_read_guard();
+        if (!ordered_index_) return OrderedConstRange();
+        return ordered_range_locked(ordered_bound_locked(e1, e2, true), ordered_index_->cend(), lock);
+    }
+
+    // ordered_between: elements with lo <= key < hi (empty if hi is not after lo).
+    [[nodiscard]] OrderedConstRange ordered_between(const std::pair<elem1_type, elem2_type> &lo,
+                                                    const std::pair<elem1_type, elem2_type> &hi) const {
+        if constexpr (!MaintainOrderedIndex) return OrderedConstRange();
+        auto lock = make_ordered_read_guard();
+        if (!ordered_index_) return OrderedConstRange();
+        auto b = ordered_bound_locked(lo.first, lo.second, false);
+        if (!cmp_(lo.first, lo.second, hi.first, hi.second)) return ordered_range_locked(b, b, lock);
+        return ordered_range_locked(b, ordered_bound_locked(hi.first, hi.second, false), lock);
+    }
+
+    //==============================================================================
+    // PUBLISHED ORDERED SNAPSHOTS
+    //==============================================================================
+
+    // Latest published snapshot of the ordered view: one atomic pointer load, no lock, so render
+    // threads never hold up writers while they draw. Publication happens on the writer side once
+    // enable_ordered_snapshots() turned it on: writers republish after max_changes index changes,
+    // or once the current snapshot is older than max_age and changes are pending (see
+    // set_snapshot_cadence()). Until the first publication this is an empty snapshot (version 0).
+    [[nodiscard]] ordered_snapshot_ptr ordered_snapshot() const noexcept {
+        return snapshot_.load(std::memory_order_acquire);
+    }
+
+    // Turn writer-side publication on (publishing the current state right away) or off (the last
+    // snapshot stays readable).
+    void enable_ordered_snapshots(bool enabled = true) {
+        if constexpr (!MaintainOrderedIndex) return;
+        std::lock_guard<std::mutex> build(snapshot_build_mtx_);
+        if (enabled) publish_ordered_snapshot_locked();
+        snapshots_enabled_.store(enabled, std::memory_order_release);
+    }
+
+    // Publish a fresh snapshot now (e.g. right before a frame that must show the latest state).
+    void publish_ordered_snapshot() {
+        if constexpr (!MaintainOrderedIndex) return;
+        std::lock_guard<std::mutex> build(snapshot_build_mtx_);
+        publish_ordered_snapshot_locked();
+        snapshots_enabled_.store(true, std::memory_order_release);
+    }
+
+    // Publish only if index changes are pending since the last snapshot; a cheap timer tick that
+    // lets a collection whose writers went quiet catch up. Returns whether it published.
+    bool publish_pending_ordered_snapshot() {
+        if constexpr (!MaintainOrderedIndex) return false;
+        if (ordered_changes_.load(std::memory_order_relaxed) == 0) return false;
+        publish_ordered_snapshot();
+        return true;
+    }
+
+    // Publication cadence: after max_changes index changes (0 = no count trigger) and/or once
+    // pending changes are older than max_age (0 = no age trigger). Defaults: 1024 changes, 16 ms.
+    void set_snapshot_cadence(std::size_t max_changes, std::chrono::milliseconds max_age) {
+        snapshot_max_changes_.store(max_changes, std::memory_order_relaxed);
+        snapshot_max_age_us_.store(std::chrono::duration_cast<std::chrono::microseconds>(max_age).count(),
+                                   std::memory_order_relaxed);
+    }
+
+private:
+    //==============================================================================
+    // ORDERED INDEX HELPERS
+    //==============================================================================
+
+    static std::int64_t snapshot_clock_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void note_ordered_change(std::size_t changes = 1) {
+        if constexpr (MaintainOrderedIndex) ordered_changes_.fetch_add(changes, std::memory_order_relaxed);
+    }
+
+    // Called by writers after they released the ordered lock; publishers never queue up.
+    void maybe_publish_ordered_snapshot() const {
+        if constexpr (!MaintainOrderedIndex) return;
+        if (!snapshots_enabled_.load(std::memory_order_acquire)) return;
+        const std::size_t pending = ordered_changes_.load(std::memory_order_relaxed);
+        if (pending == 0) return;
+        const std::size_t max_changes = snapshot_max_changes_.load(std::memory_order_relaxed);
+        const std::int64_t max_age_us = snapshot_max_age_us_.load(std::memory_order_relaxed);
+        bool due = max_changes > 0 && pending >= max_changes;
+        if (!due && max_age_us > 0) {
+            due = snapshot_clock_us() - snapshot_published_us_.load(std::memory_order_relaxed) >= max_age_us;
+        }
+        if (!due) return;
+        std::unique_lock<std::mutex> build(snapshot_build_mtx_, std::try_to_lock);
+        if (!build.owns_lock()) return;  // another thread is already publishing
+        publish_ordered_snapshot_locked();
+    }
+
+    // Caller holds snapshot_build_mtx_. Changes racing with the copy stay counted for the next one.
+    void publish_ordered_snapshot_locked() const {
+        auto snap = std::make_shared<OrderedSnapshot>();
+        ordered_changes_.store(0, std::memory_order_relaxed);
+        {
+            std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+            auto epoch = ordered_epoch_pin();
+            if (ordered_index_) {
+                snap->entries.reserve(ordered_index_->size());
+                for (const auto &v : *ordered_index_) snap->entries.push_back(ordered_deref(v));
+            }
+        }
+        snap->version = ++snapshot_version_;
+        snap->published_at = std::chrono::steady_clock::now();
+        snapshot_published_us_.store(snapshot_clock_us(), std::memory_order_relaxed);
+        // The superseded version is dropped after the swap (or later, by the last reader holding it).
+        (void)snapshot_.exchange(std::move(snap), std::memory_order_acq_rel);
+    }
+
+    // Shared ordered_mtx_ lock for a view; the skip list also needs an epoch pin, taken after
+    // the lock so it belongs to the index the view iterates.
+    ordered_lock_ptr make_ordered_read_guard() const {
+        auto guard = std::make_shared<OrderedReadGuard>();
+        guard->lock = std::shared_lock<std::shared_mutex>(ordered_mtx_);
+        guard->epoch = ordered_epoch_pin();
+        return guard;
+    }
+
+    // Caller holds ordered_mtx_ (shared or exclusive).
+    detail::EpochDomain::Guard ordered_epoch_pin() const {
+        if constexpr (ordered_concurrent) {
+            if (ordered_index_) return ordered_index_->pin();
+        }
+        return {};
+    }
+
+    // First index position whose key is not before (after, if upper) (e1, e2). Caller holds ordered_mtx_.
+    ordered_underlying_const_it ordered_bound_locked(const elem1_type &e1, const elem2_type &e2, bool upper) const {
+        const OrderedEntry probe{e1, e2, upper ? std::numeric_limits<id_type>::max() : id_type{0}};
+        return ordered_index_->lower_bound(probe);
+    }
+
+    OrderedConstRange ordered_range_locked(ordered_underlying_const_it b, ordered_underlying_const_it e,
+                                           ordered_lock_ptr lock) const {
+        return OrderedConstRange(this, b, e, ordered_underlying_const_rit(e), ordered_underlying_const_rit(b), std::move(lock));
+    }
+
+    ordered_comparator_type make_ordered_comparator() const {
+        if constexpr (ordered_caches_keys) {
+            return EntryComparator(cmp_);
+        } else {
+            return IdComparator(this, cmp_);
+        }
+    }
+
+    static ordered_value_type make_ordered_value(id_type id, const elem1_type &e1, const elem2_type &e2) {
+        if constexpr (ordered_caches_keys) {
+            return OrderedEntry{e1, e2, id};
+        } else {
+            (void)e1;
+            (void)e2;
+            return id;
+        }
+    }
+
+    // Index mutation helpers (caller holds ordered_mtx_ exclusively, or shared plus the element's
+    // submap lock for the concurrent skip list). While a cached-key rebuild
+    // is in flight, every change is also logged so it can be replayed onto the new index.
+    void ordered_insert_locked(id_type id, const elem1_type &e1, const elem2_type &e2) {
+        if (!ordered_index_) return;
+        ordered_index_->insert(make_ordered_value(id, e1, e2));
+        if (rebuild_log_) rebuild_log_->push_back({std::nullopt, OrderedEntry{e1, e2, id}});
+    }
+
+    void ordered_erase_locked(id_type id, const elem1_type &e1, const elem2_type &e2) {
+        if (!ordered_index_) return;
+        ordered_index_->erase(make_ordered_value(id, e1, e2));
+        if (rebuild_log_) rebuild_log_->push_back({OrderedEntry{e1, e2, id}, std::nullopt});
+        refill_top_k_locked();
+    }
+
+    void ordered_replace_locked(id_type id, const elem1_type &old1, const elem2_type &old2,
+                                const elem1_type &new1, const elem2_type &new2) {
+        if (!ordered_index_) return;
+        replace_ordered_entry(OrderedEntry{old1, old2, id}, OrderedEntry{new1, new2, id});
+        if (rebuild_log_) rebuild_log_->push_back({OrderedEntry{old1, old2, id}, OrderedEntry{new1, new2, id}});
+        refill_top_k_locked();
+    }
+
+    // MaintainTopK: once fewer than K entries are tracked, scan elems_ (one submap lock at a
+    // time) for the best untracked entries. Callers hold ordered_mtx_ exclusively and no submap
+    // lock; elems_ already reflects the change that shrank the set.
+    void refill_top_k_locked() {
+        if constexpr (ordered_top_k) {
+            if (!ordered_index_->needs_refill()) return;
+            const OrderedEntry *threshold = ordered_index_->threshold();
+            const EntryComparator cmp = ordered_index_->key_comp();
+            const std::size_t room = ordered_index_->refill_room();
+            // Min-heap of the best `room` untracked entries seen so far.
+            auto worse = [&cmp](const OrderedEntry &a, const OrderedEntry &b) { return cmp(b, a); };
+            std::vector<OrderedEntry> best;
+            best.reserve(room);
+            std::size_t untracked = 0;
+            const std::size_t submaps = elems_.subcnt();
+            for (std::size_t i = 0; i < submaps; ++i) {
+                elems_.with_submap(i, [&](const auto &submap) {
+                    for (const auto &pair : submap) {
+                        OrderedEntry e{pair.second.lastElem1, pair.second.lastElem2, pair.first};
+                        if (threshold && !cmp(e, *threshold)) continue;  // already tracked
+                        ++untracked;
+                        if (best.size() < room) {
+                            best.push_back(std::move(e));
+                            std::push_heap(best.begin(), best.end(), worse);
+                        } else if (room > 0 && cmp(best.front(), e)) {
+                            std::pop_heap(best.begin(), best.end(), worse);
+                            best.back() = std::move(e);
+                            std::push_heap(best.begin(), best.end(), worse);
+                        }
+                    }
+                });
+            }
+            ordered_index_->refill(std::move(best), untracked <= room);
+        }
+    }
+
+    // Copy (lastElem1, lastElem2, id) out of every elems_ submap, one submap lock at a time.
+    std::vector<OrderedEntry> snapshot_ordered_entries(std::size_t threads) const {
+        const std::size_t submaps = elems_.subcnt();
+        threads = std::max<std::size_t>(1, std::min(threads, submaps));
+        std::vector<std::vector<OrderedEntry>> parts(submaps);
+        detail::run_parallel(threads, [&](std::size_t t) {
+            for (std::size_t i = t; i < submaps; i += threads) {
+                elems_.with_submap(i, [&](const auto &submap) {
+                    parts[i].reserve(submap.size());
+                    for (const auto &pair : submap) {
+                        parts[i].push_back(OrderedEntry{pair.second.lastElem1, pair.second.lastElem2, pair.first});
+                    }
+                });
+            }
+        });
+        std::size_t total = 0;
+        for (const auto &part : parts) total += part.size();
+        std::vector<OrderedEntry> entries;
+        entries.reserve(total);
+        for (auto &part : parts) entries.insert(entries.end(), part.begin(), part.end());
+        return entries;
+    }
+
+    // O(n) bulk load from entries sorted by the set's comparator.
+    static void bulk_load_ordered_index(ordered_set_type &set, std::vector<OrderedEntry> &&sorted) {
+        if constexpr (ordered_uses_blocks || ordered_concurrent || ordered_top_k) {
+            set.assign_sorted(std::move(sorted));
+        } else {
+            for (const auto &e : sorted) set.insert(set.end(), make_ordered_value(e.id, e.elem1, e.elem2));
+        }
+    }
+
+    OrderedRebuildStats rebuild_ordered_index_with(std::optional<compare_holder_type> new_cmp, std::size_t threads) {
+        using clock = std::chrono::steady_clock;
+        auto since = [](clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+        };
+
+        // One rebuild at a time; cmp_ is only replaced here, so reading it under rebuild_mtx_ is safe.
+        std::lock_guard<std::mutex> rebuild_guard(rebuild_mtx_);
+        OrderedRebuildStats stats;
+        stats.threads = detail::worker_count(threads);
+        const compare_holder_type cmp = new_cmp ? std::move(*new_cmp) : cmp_;
+        std::optional<ordered_set_type> new_set;  // previous index destructs after the lock is released
+
+        if constexpr (!ordered_caches_keys || ordered_concurrent || ordered_top_k) {
+            // Id trees compare through elems_, so element state must stay frozen while building.
+            // Skip-list writers hold ordered_mtx_ shared, so the exclusive lock also quiesces them;
+            // a top-K set keeps only part of the order, which a change log cannot replay onto.
+            std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
+            const auto locked_at = clock::now();
+            if (!ordered_index_) return stats;
+            auto entries = snapshot_ordered_entries(stats.threads);
+            stats.snapshot_time = since(locked_at);
+            auto phase = clock::now();
+            detail::parallel_sort(entries.begin(), entries.end(), EntryComparator(cmp), stats.threads);
+            stats.sort_time = since(phase);
+            phase = clock::now();
+            cmp_ = cmp;
+            new_set.emplace(make_ordered_comparator());
+            stats.elements = entries.size();
+            bulk_load_ordered_index(*new_set, std::move(entries));
+            ordered_index_.swap(new_set);
+            stats.build_time = since(phase);
+            stats.swap_time = since(locked_at);
+            last_rebuild_stats_ = stats;
+        } else {
+            {
+                std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
+                if (!ordered_index_) return stats;
+                rebuild_log_.emplace();
+            }
+            auto phase = clock::now();
+            auto entries = snapshot_ordered_entries(stats.threads);
+            stats.snapshot_time = since(phase);
+            phase = clock::now();
+            detail::parallel_sort(entries.begin(), entries.end(), EntryComparator(cmp), stats.threads);
+            stats.sort_time = since(phase);
+            phase = clock::now();
+            new_set.emplace(EntryComparator(cmp));
+            bulk_load_ordered_index(*new_set, std::move(entries));
+            stats.build_time = since(phase);
+
+            std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
+            const auto locked_at = clock::now();
+            // Replaying the whole log in order converges on the live state even when the snapshot
+            // already observed some of these changes (set insert/erase are idempotent per entry).
+            for (const auto &change : *rebuild_log_) {
+                if (change.before) new_set->erase(*change.before);
+                if (change.after) new_set->insert(*change.after);
+            }
+            stats.replayed_changes = rebuild_log_->size();
+            rebuild_log_.reset();
+            cmp_ = cmp;
+            ordered_index_.swap(new_set);
+            stats.elements = ordered_index_->size();
+            stats.swap_time = since(locked_at);
+            last_rebuild_stats_ = stats;
+        }
+        return stats;
+    }
+
+    // Element state change logged while a recompute scan runs (nullopt: absent).
+    struct RecomputeChange {
+        id_type id;
+        std::optional<std::pair<elem1_type, elem2_type>> before;
+        std::optional<std::pair<elem1_type, elem2_type>> after;
+    };
+
+    // Whether the change being applied publishes the totals under the current PublicationPolicy.
+    // Racing writers may both publish, or the n-th change may slip by one; either way the next
+    // publication carries the exact totals.
+    bool publication_due() {
+        switch (publish_mode_.load(std::memory_order_relaxed)) {
+        case PublicationPolicy::Mode::Immediate:
+            return true;
+        case PublicationPolicy::Mode::EveryN:
+            if (publish_pending_.fetch_add(1, std::memory_order_relaxed) + 1 < publish_every_n_.load(std::memory_order_relaxed))
+                return false;
+            publish_pending_.store(0, std::memory_order_relaxed);
+            return true;
+        case PublicationPolicy::Mode::Interval: {
+            const std::int64_t now = snapshot_clock_us();
+            std::int64_t last = publish_last_us_.load(std::memory_order_relaxed);
+            if (now - last < publish_interval_us_.load(std::memory_order_relaxed)) return false;
+            return publish_last_us_.compare_exchange_strong(last, now, std::memory_order_relaxed);
+        }
+        case PublicationPolicy::Mode::Manual:
+            return false;
+        }
+        return true;
+    }
+
+    // Held by a writer for its whole change; see recompute_totals(). Outside a recompute it only
+    // bumps this thread's in-flight slot, during one it holds swap_mtx shared and logs changes.
+    // Collections whose writes the calling thread is inside (observers run within the gate).
+    static std::vector<const ReactiveTwoFieldCollection *> &gates_held() {
+        thread_local std::vector<const ReactiveTwoFieldCollection *> held;
+        return held;
+    }
+
+    class RecomputeGate {
+    public:
+        explicit RecomputeGate(ReactiveTwoFieldCollection &c) {
+            if constexpr (recomputable_totals) {
+                auto &state = c.recompute_;
+                auto &slot = state.inflight[detail::thread_shard_slot() & (state.inflight.size() - 1)].writers;
+                slot.fetch_add(1);
+                if (state.active.load()) {
+                    slot.fetch_sub(1);
+                    swap_lock_ = std::shared_lock<std::shared_mutex>(state.swap_mtx);
+                    logging_ = true;
+                } else {
+                    slot_ = &slot;
+                }
+                gates_held().push_back(&c);
+                owner_ = &c;
+            } else {
+                (void)c;
+            }
+        }
+        ~RecomputeGate() { release(); }
+        RecomputeGate(const RecomputeGate &) = delete;
+        RecomputeGate &operator=(const RecomputeGate &) = delete;
+
+        void release() noexcept {
+            if (owner_) {
+                auto &held = gates_held();
+                held.erase(std::find(held.rbegin(), held.rend(), owner_).base() - 1);
+                owner_ = nullptr;
+            }
+            if (slot_) slot_->fetch_sub(1);
+            slot_ = nullptr;
+            if (swap_lock_.owns_lock()) swap_lock_.unlock();
+            logging_ = false;
+        }
+        bool logging() const noexcept { return logging_; }
+
+    private:
+        const ReactiveTwoFieldCollection *owner_ = nullptr;
+        std::atomic<std::size_t> *slot_ = nullptr;
+        std::shared_lock<std::shared_mutex> swap_lock_;
+        bool logging_ = false;
+    };
+
+    // Logs a change to rec (ne1/ne2 null: removal) when the running recompute already counted rec.
+    // Callers hold rec's submap lock, which orders the check against the scan.
+    void note_recompute_change(const RecomputeGate &gate, const ElemRecord &rec, id_type id,
+                               const elem1_type *ne1 = nullptr, const elem2_type *ne2 = nullptr) {
+        if constexpr (recomputable_totals) {
+            if (!gate.logging() || rec.scan_gen != recompute_.gen.load()) return;
+            RecomputeChange change{id, std::pair{rec.lastElem1, rec.lastElem2}, std::nullopt};
+            if (ne1 && ne2) change.after = std::pair{*ne1, *ne2};
+            std::lock_guard<std::mutex> g(recompute_.log_mtx);
+            recompute_.log.push_back(std::move(change));
+        } else {
+            (void)gate; (void)rec; (void)id; (void)ne1; (void)ne2;
+        }
+    }
+
+    // A record pushed into a submap the running recompute already scanned was missed by it:
+    // log it as an insert and mark it counted so its later changes are logged too.
+    void note_recompute_insert(const RecomputeGate &gate, ElemRecord &rec, id_type id) {
+        if constexpr (recomputable_totals) {
+            const std::uint64_t gen = recompute_.gen.load();
+            if (!gate.logging() || rec.scan_gen == gen) return;
+            if (!recompute_.scanned[elems_.subidx(elems_.hash(id))].load()) return;
+            rec.scan_gen = gen;
+            std::lock_guard<std::mutex> g(recompute_.log_mtx);
+            recompute_.log.push_back({id, std::nullopt, std::pair{rec.lastElem1, rec.lastElem2}});
+        } else {
+            (void)gate; (void)rec; (void)id;
+        }
+    }
+
+    // Per-worker result of the recompute scan.
+    struct RecomputePartial {
+        std::size_t elements = 0;
+        std::conditional_t<recompute_add1, detail::RecomputeSum<total1_type>, std::monostate> sum1{};
+        std::conditional_t<recompute_add2, detail::RecomputeSum<total2_type>, std::monostate> sum2{};
+        std::conditional_t<recompute_moments1, detail::Moments<total1_type>,
+                           std::monostate> moments1{};
+        std::conditional_t<recompute_moments2, detail::Moments<total2_type>,
+                           std::monostate> moments2{};
+
+        void merge(const RecomputePartial &other) {
+            elements += other.elements;
+            if constexpr (recompute_add1) sum1.merge(other.sum1);
+            if constexpr (recompute_add2) sum2.merge(other.sum2);
+            if constexpr (recompute_moments1) moments1.merge(other.moments1);
+            if constexpr (recompute_moments2) moments2.merge(other.moments2);
+        }
+    };
+
+    void count_for_recompute(RecomputePartial &part, const elem1_type &e1, const elem2_type &e2) const {
+        ++part.elements;
+        if constexpr (recompute_add1) part.sum1.add(delta1_(e1, e2, elem1_type{}, elem2_type{}));
+        if constexpr (recompute_add2) part.sum2.add(delta2_(e1, e2, elem1_type{}, elem2_type{}));
+        if constexpr (recompute_moments1) part.moments1.add(extract1_(e1, e2));
+        if constexpr (recompute_moments2) part.moments2.add(extract2_(e1, e2));
+    }
+
+    // Replays the logged changes onto the scan result and installs it as the live totals
+    // (caller holds swap_mtx exclusively, so no writer is mid-change; publication is left to it).
+    void install_recomputed_totals(RecomputePartial &fresh, const std::vector<RecomputeChange> &log) {
+        for (const auto &change : log) {
+            const auto before = change.before.value_or(std::pair<elem1_type, elem2_type>{});
+            const auto after = change.after.value_or(std::pair<elem1_type, elem2_type>{});
+            if constexpr (recompute_add1) fresh.sum1.add(delta1_(after.first, after.second, before.first, before.second));
+            if constexpr (recompute_add2) fresh.sum2.add(delta2_(after.first, after.second, before.first, before.second));
+            if (change.before && !change.after) --fresh.elements;
+            if (!change.before && change.after) ++fresh.elements;
+        }
+        if constexpr (recompute_moments1) idx1_.assign(fresh.moments1);
+        if constexpr (recompute_moments2) idx2_.assign(fresh.moments2);
+        for (const auto &change : log) {
+            if constexpr (recompute_moments1) {
+                if (change.before) idx1_.erase_one(extract1_(change.before->first, change.before->second), change.id);
+                if (change.after) idx1_.insert(extract1_(change.after->first, change.after->second), change.id);
+            }
+            if constexpr (recompute_moments2) {
+                if (change.before) idx2_.erase_one(extract2_(change.before->first, change.before->second), change.id);
+                if (change.after) idx2_.insert(extract2_(change.after->first, change.after->second), change.id);
+            }
+        }
+        if constexpr (recompute_add1) atomic_total1_.store(fresh.sum1.value());
+        if constexpr (recompute_add2) atomic_total2_.store(fresh.sum2.value());
+    }
+
+    // Move an entry to its new cached key, reusing the tree node where the backend allows it.
+    void replace_ordered_entry(const OrderedEntry &old_entry, const OrderedEntry &new_entry) {
+        if constexpr (ordered_uses_blocks || ordered_concurrent || ordered_top_k) {
+            // Blocks overwrite in place when the entry keeps its position within the block run.
+            ordered_index_->replace(old_entry, new_entry);
+        } else {
+            auto it = ordered_index_->find(old_entry);
+            if (it == ordered_index_->end()) {
+                ordered_index_->insert(new_entry);
+                return;
+            }
+            auto hint = std::next(it);
+            auto node = ordered_index_->extract(it);
+            node.value() = new_entry;
+            ordered_index_->insert(hint, std::move(node));
+        }
+    }
+
+    std::pair<id_type, ElemRecordSnapshot> ordered_deref(const id_type &id) const {
+        ElemRecordSnapshot snap{};
+        elems_.if_contains(id, [&](const auto &pair) {
+            snap = {pair.second.lastElem1, pair.second.lastElem2, pair.second.key};
+        });
+        return { id, snap };
+    }
+
+    std::pair<id_type, ElemRecordSnapshot> ordered_deref(const OrderedEntry &entry) const {
+        ElemRecordSnapshot snap{entry.elem1, entry.elem2, typename ElemRecord::key_storage_t{}};
+        if constexpr (has_keys) {
+            elems_.if_contains(entry.id, [&](const auto &pair) { snap.key = pair.second.key; });
+        }
+        return { entry.id, snap };
     }
 
-    [[nodiscard]] OrderedRange ordered() {
-        if constexpr (!MaintainOrderedIndex) return OrderedRange();
-        auto lock = std::make_shared<std::shared_lock<std::shared_mutex>>(ordered_mtx_);
-        if (!ordered_index_) return OrderedRange();
-        return OrderedRange(this, ordered_index_->begin(), ordered_index_->end(),
-                            ordered_index_->rbegin(), ordered_index_->rend(), lock);
+    // Value currently stored in the index for id (caller holds ordered_mtx_).
+    std::optional<ordered_value_type> ordered_probe(id_type id) const {
+        std::optional<ordered_value_type> probe;
+        elems_.if_contains(id, [&](const auto &pair) {
+            probe = make_ordered_value(id, pair.second.lastElem1, pair.second.lastElem2);
+        });
+        return probe;
     }
 
-    // top_k / bottom_k helpers (ids)
-    [[nodiscard]] std::vector<id_type> top_k(size_t k) const {
-        std::vector<id_type> out;
-        if constexpr (!MaintainOrderedIndex) return out;
-        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
-        if (!ordered_index_) return out;
-        for (auto it = ordered_index_->rbegin(); it != ordered_index_->rend() && out.size() < k; ++it) out.push_back(*it);
-        return out;
+    size_t ordered_rank_locked(ordered_underlying_const_it it) const {
+        if constexpr (ordered_uses_blocks) {
+            return ordered_index_->rank(it);
+        } else {
+            return static_cast<size_t>(std::distance(ordered_index_->cbegin(), it));
+        }
     }
-    [[nodiscard]] std::vector<id_type> bottom_k(size_t k) const {
-        std::vector<id_type> out;
-        if constexpr (!MaintainOrderedIndex) return out;
-        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
-        if (!ordered_index_) return out;
-        for (auto it = ordered_index_->begin(); it != ordered_index_->end() && out.size() < k; ++it) out.push_back(*it);
-        return out;
+
+    ordered_underlying_const_it ordered_select_locked(size_t k) const {
+        if constexpr (ordered_uses_blocks) {
+            return ordered_index_->select(k);
+        } else {
+            const size_t n = ordered_index_->size();
+            if (k >= n) return ordered_index_->cend();
+            if (k <= n / 2) return std::next(ordered_index_->cbegin(), static_cast<std::ptrdiff_t>(k));
+            return std::prev(ordered_index_->cend(), static_cast<std::ptrdiff_t>(n - k));
+        }
     }
 
-private:
+    static id_type ordered_id(const id_type &id) { return id; }
+    static id_type ordered_id(const OrderedEntry &entry) { return entry.id; }
+
     static constexpr bool apply1_is_default_add() {
         using default_t = detail::DefaultApplyAdd<Total1T, delta1_type>;
         return std::is_same_v<std::remove_cv_t<std::remove_reference_t<Apply1Fn>>, default_t>;
@@ -900,83 +3763,417 @@ private:
         return std::is_same_v<std::remove_cv_t<std::remove_reference_t<Apply2Fn>>, default_t>;
     }
 
+    template <AggMode Mode>
+    static auto make_argtotal_var() {
+        if constexpr (detail::is_extremum_mode(Mode)) return reaction::var(id_type{0});
+        else return std::monostate{};
+    }
+    template <AggMode Mode, typename TotalT>
+    static auto make_quantiles_var() {
+        if constexpr (Mode == AggMode::Quantile) return reaction::var(std::vector<TotalT>{TotalT{}});
+        else return std::monostate{};
+    }
+
+    total1_type load_total1() const {
+        if constexpr (atomic_total1 || cas_total1) return atomic_total1_.load();
+        else if constexpr (detail::is_extremum_mode(Total1Mode)) {
+            auto top = top_index1();
+            return top ? *top : total1_type{};
+        }
+        else if constexpr (Total1Mode != AggMode::Add) return idx1_.load();
+        else return total1_.get();
+    }
+    total2_type load_total2() const {
+        if constexpr (atomic_total2 || cas_total2) return atomic_total2_.load();
+        else if constexpr (detail::is_extremum_mode(Total2Mode)) {
+            auto top = top_index2();
+            return top ? *top : total2_type{};
+        }
+        else if constexpr (Total2Mode != AggMode::Add) return idx2_.load();
+        else return total2_.get();
+    }
+
     lock_type maybe_lock() const {
         if constexpr (RequireCoarseLock) return lock_type(coarse_mtx_);
         return coarse_lock_enabled_ ? lock_type(coarse_mtx_) : lock_type(coarse_mtx_, std::defer_lock);
     }
 
-    // Count-map index helpers (value -> count) used when AggMode is Min/Max and ordered_index is not enabled.
-    void insert_index1(const total1_type &v) { ++idx1_[v]; }
-    void erase_one_index1(const total1_type &v) {
-        auto it = idx1_.find(v);
-        if (it != idx1_.end()) {
-            if (--(it->second) == 0) idx1_.erase(it);
+    // Min/Max total read off the ordered index (index_total1/index_total2): the extractor is
+    // monotone in the index order, so the first (Min) or last (Max) entry holds the extremum.
+    template <typename TotalT, AggMode Mode, typename ExtractFn>
+    std::optional<std::pair<TotalT, id_type>> ordered_extremum(const ExtractFn &extract) const {
+        std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+        if (!ordered_index_ || ordered_index_->begin() == ordered_index_->end()) return std::nullopt;
+        auto epoch = ordered_epoch_pin();
+        const ordered_value_type entry = Mode == AggMode::Min ? *ordered_index_->begin() : *ordered_index_->rbegin();
+        if constexpr (ordered_caches_keys) {
+            return std::pair<TotalT, id_type>{extract(entry.elem1, entry.elem2), entry.id};
+        } else {
+            const auto snap = ordered_deref(entry);
+            return std::pair<TotalT, id_type>{extract(snap.second.lastElem1, snap.second.lastElem2), entry};
         }
     }
-	
-	std::optional<total1_type> top_index1() const {
-        if constexpr (Total1Mode == AggMode::Add) return std::nullopt;
-        // use count map to derive min/max of extractor values
-        if (idx1_.empty()) return std::nullopt;
-        if constexpr (Total1Mode == AggMode::Min) {
-            return idx1_.begin()->first;
-        } else { // Max
-            return idx1_.rbegin()->first;
+
+    // Extractor tracker helpers (detail::extract_aggregate over extractor values; no-ops when the
+    // ordered index drives a Min/Max total).
+    void insert_index1(const total1_type &v, id_type id) {
+        if constexpr (!index_total1) idx1_.insert(v, id);
+    }
+    void erase_one_index1(const total1_type &v, id_type id) {
+        if constexpr (!index_total1) idx1_.erase_one(v, id);
+    }
+    // Extremum and an element holding it.
+    std::optional<std::pair<total1_type, id_type>> top_entry1() const {
+        if constexpr (!detail::is_extremum_mode(Total1Mode)) return std::nullopt;
+        else if constexpr (index_total1) return ordered_extremum<total1_type, Total1Mode>(extract1_);
+        else return idx1_.top_entry();
+    }
+    std::optional<total1_type> top_index1() const {
+        auto entry = top_entry1();
+        if (!entry) return std::nullopt;
+        return entry->first;
+    }
+    id_type load_argtotal1() const {
+        auto entry = top_entry1();
+        return entry ? entry->second : id_type{0};
+    }
+
+    void insert_index2(const total2_type &v, id_type id) {
+        if constexpr (!index_total2) idx2_.insert(v, id);
+    }
+    void erase_one_index2(const total2_type &v, id_type id) {
+        if constexpr (!index_total2) idx2_.erase_one(v, id);
+    }
+    // Extremum and an element holding it.
+    std::optional<std::pair<total2_type, id_type>> top_entry2() const {
+        if constexpr (!detail::is_extremum_mode(Total2Mode)) return std::nullopt;
+        else if constexpr (index_total2) return ordered_extremum<total2_type, Total2Mode>(extract2_);
+        else return idx2_.top_entry();
+    }
+    std::optional<total2_type> top_index2() const {
+        auto entry = top_entry2();
+        if (!entry) return std::nullopt;
+        return entry->first;
+    }
+    id_type load_argtotal2() const {
+        auto entry = top_entry2();
+        return entry ? entry->second : id_type{0};
+    }
+
+    // Rewrites a Quantile total and its quantile Var after the configuration changed.
+    template <int Which>
+    void republish_quantiles() {
+        auto write = [this] {
+            if constexpr (Which == 1) {
+                total1_publisher_.publish_changes([this] { return load_total1(); }, total1_);
+                quantiles1_publisher_.publish_changes([this] { return idx1_.values(); }, quantiles1_);
+            } else {
+                total2_publisher_.publish_changes([this] { return load_total2(); }, total2_);
+                quantiles2_publisher_.publish_changes([this] { return idx2_.values(); }, quantiles2_);
+            }
+        };
+        if (combined_atomic_) {
+            std::lock_guard<std::mutex> g(combined_mtx_);
+            reaction::batchExecute(write);
+        } else {
+            write();
         }
     }
 
-    void insert_index2(const total2_type &v) { ++idx2_[v]; }
-    void erase_one_index2(const total2_type &v) {
-        auto it = idx2_.find(v);
-        if (it != idx2_.end()) {
-            if (--(it->second) == 0) idx2_.erase(it);
+    // Sliding-window and decayed views of one Add total's deltas; each part is off until enabled.
+    template <typename T>
+    struct FlowTotals {
+        detail::SlidingWindowTotal<T> window;
+        detail::DecayedTotal<> decay;
+        reaction::Var<T> window_var = reaction::var(T{});
+        reaction::Var<double> decay_var = reaction::var(0.0);
+        detail::TotalPublisher window_publisher;
+        detail::TotalPublisher decay_publisher;
+
+        bool active() const noexcept { return window.enabled() || decay.enabled(); }
+        template <typename D>
+        void record(const D &d, std::chrono::steady_clock::time_point now) {
+            if (window.enabled()) window.add(d, now);
+            if (decay.enabled()) decay.add(d, now);
         }
+        // Writes the values that changed (expiry and decay included).
+        void publish(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+            if (window.enabled()) window_publisher.publish_changes([&] { return window.load(now); }, window_var);
+            if (decay.enabled()) decay_publisher.publish_changes([&] { return decay.load(now); }, decay_var);
+        }
+    };
+
+    bool flows_active() const noexcept {
+        bool active = false;
+        if constexpr (flow_total1) active = active || flows1_.active();
+        if constexpr (flow_total2) active = active || flows2_.active();
+        return active;
     }
-	
-	std::optional<total2_type> top_index2() const {
-        if constexpr (Total2Mode == AggMode::Add) return std::nullopt;
-        if (idx2_.empty()) return std::nullopt;
-        if constexpr (Total2Mode == AggMode::Min) {
-            return idx2_.begin()->first;
-        } else {
-            return idx2_.rbegin()->first;
+    void record_flows(const delta1_type &d1, const delta2_type &d2) {
+        if (!flows_active()) return;
+        const auto now = std::chrono::steady_clock::now();
+        if constexpr (flow_total1) flows1_.record(d1, now);
+        if constexpr (flow_total2) flows2_.record(d2, now);
+    }
+    void publish_flows(flow_time_point now = flow_clock::now()) {
+        if constexpr (flow_total1) {
+            if (flows1_.active()) flows1_.publish(now);
+        }
+        if constexpr (flow_total2) {
+            if (flows2_.active()) flows2_.publish(now);
+        }
+    }
+
+    // Element values before/after a change, for the extra aggregates' extractors and GroupFn (null
+    // when absent; key is only read by a GroupFn taking the key).
+    struct elem_view {
+        const elem1_type *e1 = nullptr;
+        const elem2_type *e2 = nullptr;
+        const KeyT *key = nullptr;
+        explicit operator bool() const noexcept { return e1 != nullptr; }
+    };
+
+    // Per-descriptor state of an extra aggregate.
+    template <typename Agg>
+    struct ExtraAggregateState {
+        using total_type = typename Agg::total_type;
+        typename Agg::extract_type extract{};
+        typename detail::extract_aggregate<Agg::mode, total_type, std::size_t>::type tracker{};
+        reaction::Var<total_type> var = reaction::var(total_type{});
+        detail::TotalPublisher publisher;
+    };
+
+    void update_extras(elem_view old_elems, elem_view new_elems, id_type id) {
+        std::apply([&](auto &...st) {
+            auto update = [&](auto &state) {
+                using T = typename std::remove_reference_t<decltype(state)>::total_type;
+                if (old_elems) {
+                    state.tracker.erase_one(detail::bounded_numeric_cast<T>(state.extract(*old_elems.e1, *old_elems.e2)), id);
+                }
+                if (new_elems) {
+                    state.tracker.insert(detail::bounded_numeric_cast<T>(state.extract(*new_elems.e1, *new_elems.e2)), id);
+                }
+            };
+            (update(st), ...);
+        }, extras_);
+    }
+    void publish_extras() {
+        std::apply([](auto &...st) {
+            (st.publisher.publish_changes([&st] { return st.tracker.load(); }, st.var), ...);
+        }, extras_);
+    }
+    // Every group's changed totals (flush()). Groups are collected first so observers run without
+    // a groups_ submap lock.
+    void publish_all_groups() {
+        if constexpr (grouped) {
+            std::vector<group_ptr> all;
+            groups_.for_each([&](const auto &pair) { all.push_back(pair.second); });
+            for (const auto &st : all) st->publish();
+        }
+    }
+    // Combined mode: the extra totals that changed since their Var was written (nullopt otherwise).
+    auto changed_extras() const {
+        return std::apply([](const auto &...st) {
+            auto changed = [](const auto &state) {
+                using T = typename std::remove_reference_t<decltype(state)>::total_type;
+                const T v = state.tracker.load();
+                return state.var.get() == v ? std::optional<T>{} : std::optional<T>{v};
+            };
+            return std::make_tuple(changed(st)...);
+        }, extras_);
+    }
+    template <typename Changed>
+    void write_extras(Changed &changed) {
+        write_extras(changed, std::index_sequence_for<ExtraAggregates...>{});
+    }
+    template <typename Changed, std::size_t... Is>
+    void write_extras(Changed &changed, std::index_sequence<Is...>) {
+        ((std::get<Is>(changed) ? std::get<Is>(extras_).var.value(*std::get<Is>(changed)) : void()), ...);
+    }
+
+    // Totals of one group: Add modes fold deltas with the collection's apply functors, other modes
+    // keep a detail::extract_aggregate tracker. mtx guards count and the Add totals; groups_'
+    // submap lock is held around every modification so prune_empty_groups() sees stable counts.
+    template <AggMode Mode, typename TotalT>
+    using group_tracker_t = std::conditional_t<Mode == AggMode::Add, std::monostate,
+                                               typename detail::extract_aggregate<Mode, TotalT, std::size_t>::type>;
+    struct GroupState {
+        mutable std::mutex mtx;
+        std::ptrdiff_t count = 0;
+        total1_type total1{};
+        total2_type total2{};
+        group_tracker_t<Total1Mode, total1_type> tracker1{};
+        group_tracker_t<Total2Mode, total2_type> tracker2{};
+        reaction::Var<total1_type> var1 = reaction::var(total1_type{});
+        reaction::Var<total2_type> var2 = reaction::var(total2_type{});
+        detail::TotalPublisher publisher1;
+        detail::TotalPublisher publisher2;
+
+        total1_type load1() const {
+            if constexpr (Total1Mode == AggMode::Add) {
+                std::lock_guard<std::mutex> g(mtx);
+                return total1;
+            } else {
+                return tracker1.load();
+            }
+        }
+        total2_type load2() const {
+            if constexpr (Total2Mode == AggMode::Add) {
+                std::lock_guard<std::mutex> g(mtx);
+                return total2;
+            } else {
+                return tracker2.load();
+            }
+        }
+        // Writes only the totals that changed.
+        void publish() {
+            publisher1.publish_changes([this] { return load1(); }, var1);
+            publisher2.publish_changes([this] { return load2(); }, var2);
+        }
+    };
+    using group_ptr = std::shared_ptr<GroupState>;
+
+    template <typename Load>
+    auto top_groups_by(std::size_t n, Load load) const {
+        using total_t = decltype(load(std::declval<const GroupState &>()));
+        std::vector<std::pair<group_type, total_t>> all;
+        groups_.for_each([&](const auto &pair) { all.emplace_back(pair.first, load(*pair.second)); });
+        n = std::min(n, all.size());
+        auto by_total = [](const auto &a, const auto &b) { return b.second < a.second; };
+        std::partial_sort(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(n), all.end(), by_total);
+        all.resize(n);
+        return all;
+    }
+
+    group_type group_of(const elem_view &v) const {
+        if constexpr (detail::group_by_key_v<GroupFn, KeyT, Elem1T, Elem2T>) return group_fn_(*v.key, *v.e1, *v.e2);
+        else return group_fn_(*v.e1, *v.e2);
+    }
+
+    // Runs fn on the state of group g under its submap lock, creating the group on first use.
+    template <typename Fn>
+    group_ptr with_group(const group_type &g, Fn &&fn) {
+        group_ptr st;
+        auto visit = [&](auto &pair) {
+            st = pair.second;
+            fn(*pair.second);
+        };
+        // A concurrent prune_empty_groups() may drop a fresh group before we visit it; retry.
+        while (!groups_.modify_if(g, visit)) groups_.insert(std::make_pair(g, std::make_shared<GroupState>()));
+        return st;
+    }
+
+    // Moves one element change into its group(s): an element whose group is unchanged gets the
+    // same delta / extractor transition as the collection totals, one that switches groups leaves
+    // the old group (remove delta) and joins the new one (insert delta). Returns the touched groups
+    // for publication.
+    std::pair<group_ptr, group_ptr> update_groups(const delta1_type &d1, const delta2_type &d2,
+                                                  const total1_type *old1, const total1_type *new1,
+                                                  const total2_type *old2, const total2_type *new2,
+                                                  id_type id, elem_view old_elems, elem_view new_elems) {
+        std::optional<group_type> old_group, new_group;
+        if (old_elems) old_group = group_of(old_elems);
+        if (new_elems) new_group = group_of(new_elems);
+        const bool same = old_group && new_group && *old_group == *new_group;
+
+        auto change = [&](GroupState &st, bool leave, bool join, const delta1_type &g1, const delta2_type &g2) {
+            std::lock_guard<std::mutex> lk(st.mtx);
+            st.count += (join ? 1 : 0) - (leave ? 1 : 0);
+            if constexpr (Total1Mode == AggMode::Add) {
+                (void)apply1_(st.total1, g1);
+            } else {
+                if (leave && old1) st.tracker1.erase_one(*old1, id);
+                if (join && new1) st.tracker1.insert(*new1, id);
+            }
+            if constexpr (Total2Mode == AggMode::Add) {
+                (void)apply2_(st.total2, g2);
+            } else {
+                if (leave && old2) st.tracker2.erase_one(*old2, id);
+                if (join && new2) st.tracker2.insert(*new2, id);
+            }
+        };
+
+        if (same) {
+            return {with_group(*new_group, [&](GroupState &st) { change(st, true, true, d1, d2); }), nullptr};
         }
+        group_ptr left, joined;
+        if (old_group) {
+            const delta1_type r1 = delta1_(elem1_type{}, elem2_type{}, *old_elems.e1, *old_elems.e2);
+            const delta2_type r2 = delta2_(elem1_type{}, elem2_type{}, *old_elems.e1, *old_elems.e2);
+            left = with_group(*old_group, [&](GroupState &st) { change(st, true, false, r1, r2); });
+        }
+        if (new_group) {
+            const delta1_type a1 = delta1_(*new_elems.e1, *new_elems.e2, elem1_type{}, elem2_type{});
+            const delta2_type a2 = delta2_(*new_elems.e1, *new_elems.e2, elem1_type{}, elem2_type{});
+            joined = with_group(*new_group, [&](GroupState &st) { change(st, false, true, a1, a2); });
+        }
+        return {left, joined};
     }
 
     // apply_pair handles additive and index modes; parameters describe optional old/new extractor values
+    // of element id (Min/Max modes key their extremum index by it) and, for extra aggregates, the
+    // element values themselves.
     void apply_pair(const delta1_type &d1, const delta2_type &d2,
                     bool have_old1 = false, const total1_type *old1 = nullptr,
                     bool have_new1 = false, const total1_type *new1 = nullptr,
                     bool have_old2 = false, const total2_type *old2 = nullptr,
-                    bool have_new2 = false, const total2_type *new2 = nullptr)
+                    bool have_new2 = false, const total2_type *new2 = nullptr,
+                    id_type id = 0, elem_view old_elems = {}, elem_view new_elems = {})
     {
-        if (!combined_atomic_) {
-            // non-combined path: apply/update each total separately
-
-            // Total1: Add vs Min/Max
-            if constexpr (Total1Mode == AggMode::Add) {
-                apply_total1(d1);
-            } else {
-                // Update count-map indices unconditionally when extractor values provided
-                if (have_old1 && old1) erase_one_index1(*old1);
-                if (have_new1 && new1) insert_index1(*new1);
+        if constexpr (flow_total1 || flow_total2) record_flows(d1, d2);
+        const bool publish_totals = publication_due();
 
-                auto top1 = top_index1();
-                if (top1) total1_.value(*top1);
-                else total1_.value(total1_type{});
-            }
+        if (!combined_atomic_) {
+            // non-combined path: apply/update each total separately. With extra aggregates, the
+            // totals and extra Vars are written in one batch, so an observer of several of them
+            // fires once per change.
+            auto apply_separately = [&] {
+                // Total1: Add vs extractor-driven modes
+                if constexpr (Total1Mode == AggMode::Add) {
+                    apply_total1(d1, publish_totals);
+                } else {
+                    // Update count-map indices unconditionally when extractor values provided
+                    if (have_old1 && old1) erase_one_index1(*old1, id);
+                    if (have_new1 && new1) insert_index1(*new1, id);
+                    if (publish_totals) {
+                        total1_publisher_.publish_changes([this] { return load_total1(); }, total1_);
+                        if constexpr (detail::is_extremum_mode(Total1Mode))
+                            argtotal1_publisher_.publish_changes([this] { return load_argtotal1(); }, argtotal1_);
+                        if constexpr (Total1Mode == AggMode::Quantile)
+                            quantiles1_publisher_.publish_changes([this] { return idx1_.values(); }, quantiles1_);
+                    }
+                }
 
-            // Total2: Add vs Min/Max
-            if constexpr (Total2Mode == AggMode::Add) {
-                apply_total2(d2);
-            } else {
-                if (have_old2 && old2) erase_one_index2(*old2);
-                if (have_new2 && new2) insert_index2(*new2);
+                // Total2: Add vs extractor-driven modes
+                if constexpr (Total2Mode == AggMode::Add) {
+                    apply_total2(d2, publish_totals);
+                } else {
+                    if (have_old2 && old2) erase_one_index2(*old2, id);
+                    if (have_new2 && new2) insert_index2(*new2, id);
+                    if (publish_totals) {
+                        total2_publisher_.publish_changes([this] { return load_total2(); }, total2_);
+                        if constexpr (detail::is_extremum_mode(Total2Mode))
+                            argtotal2_publisher_.publish_changes([this] { return load_argtotal2(); }, argtotal2_);
+                        if constexpr (Total2Mode == AggMode::Quantile)
+                            quantiles2_publisher_.publish_changes([this] { return idx2_.values(); }, quantiles2_);
+                    }
+                }
 
-                auto top2 = top_index2();
-                if (top2) total2_.value(*top2);
-                else total2_.value(total2_type{});
-            }
+                if constexpr (sizeof...(ExtraAggregates) > 0) {
+                    update_extras(old_elems, new_elems, id);
+                    if (publish_totals) publish_extras();
+                }
+                if constexpr (grouped) {
+                    auto touched = update_groups(d1, d2, old1, new1, old2, new2, id, old_elems, new_elems);
+                    if (publish_totals) {
+                        if (touched.first) touched.first->publish();
+                        if (touched.second) touched.second->publish();
+                    }
+                }
+                if constexpr (flow_total1 || flow_total2) publish_flows();
+            };
+            if constexpr (sizeof...(ExtraAggregates) > 0) reaction::batchExecute(apply_separately);
+            else apply_separately();
             return;
         }
 
@@ -987,21 +4184,46 @@ private:
 
         bool changed1 = false;
         bool changed2 = false;
-
-        // For Min/Max: update the idx maps first (so top_index* sees latest values)
+        [[maybe_unused]] id_type arg1 = 0, arg2 = 0;
+        bool arg_changed1 = false;
+        bool arg_changed2 = false;
+        [[maybe_unused]] std::vector<total1_type> qs1;
+        [[maybe_unused]] std::vector<total2_type> qs2;
+        bool qs_changed1 = false;
+        bool qs_changed2 = false;
+
+        // Extractor-driven modes: update the idx trackers first (so top_entry* / load see latest values)
         if constexpr (Total1Mode != AggMode::Add) {
-            if (have_old1 && old1) erase_one_index1(*old1);
-            if (have_new1 && new1) insert_index1(*new1);
+            if (have_old1 && old1) erase_one_index1(*old1, id);
+            if (have_new1 && new1) insert_index1(*new1, id);
 
-            auto top1 = top_index1();
-            if (top1) {
-                if (cur1 != *top1) { cur1 = *top1; changed1 = true; }
+            if constexpr (detail::is_extremum_mode(Total1Mode)) {
+                auto top1 = top_entry1();
+                if (top1) {
+                    if (cur1 != top1->first) { cur1 = top1->first; changed1 = true; }
+                } else {
+                    if (cur1 != total1_type{}) { cur1 = total1_type{}; changed1 = true; }
+                }
+                arg1 = top1 ? top1->second : id_type{0};
+                arg_changed1 = arg1 != argtotal1_.get();
             } else {
-                if (cur1 != total1_type{}) { cur1 = total1_type{}; changed1 = true; }
+                const total1_type v = idx1_.load();
+                if (cur1 != v) { cur1 = v; changed1 = true; }
+                if constexpr (Total1Mode == AggMode::Quantile) {
+                    qs1 = idx1_.values();
+                    qs_changed1 = qs1 != quantiles1_.get();
+                }
             }
         } else {
             // Add mode
-            if constexpr (apply1_is_default_add()) {
+            if constexpr (atomic_total1) {
+                atomic_total1_.add(d1);
+                cur1 = atomic_total1_.load();
+                changed1 = true;
+            } else if constexpr (cas_total1) {
+                changed1 = atomic_total1_.apply(apply1_, d1);
+                cur1 = atomic_total1_.load();
+            } else if constexpr (apply1_is_default_add()) {
                 cur1 += d1;
                 changed1 = true;
             } else {
@@ -1010,17 +4232,35 @@ private:
         }
 
         if constexpr (Total2Mode != AggMode::Add) {
-            if (have_old2 && old2) erase_one_index2(*old2);
-            if (have_new2 && new2) insert_index2(*new2);
+            if (have_old2 && old2) erase_one_index2(*old2, id);
+            if (have_new2 && new2) insert_index2(*new2, id);
 
-            auto top2 = top_index2();
-            if (top2) {
-                if (cur2 != *top2) { cur2 = *top2; changed2 = true; }
+            if constexpr (detail::is_extremum_mode(Total2Mode)) {
+                auto top2 = top_entry2();
+                if (top2) {
+                    if (cur2 != top2->first) { cur2 = top2->first; changed2 = true; }
+                } else {
+                    if (cur2 != total2_type{}) { cur2 = total2_type{}; changed2 = true; }
+                }
+                arg2 = top2 ? top2->second : id_type{0};
+                arg_changed2 = arg2 != argtotal2_.get();
             } else {
-                if (cur2 != total2_type{}) { cur2 = total2_type{}; changed2 = true; }
+                const total2_type v = idx2_.load();
+                if (cur2 != v) { cur2 = v; changed2 = true; }
+                if constexpr (Total2Mode == AggMode::Quantile) {
+                    qs2 = idx2_.values();
+                    qs_changed2 = qs2 != quantiles2_.get();
+                }
             }
         } else {
-            if constexpr (apply2_is_default_add()) {
+            if constexpr (atomic_total2) {
+                atomic_total2_.add(d2);
+                cur2 = atomic_total2_.load();
+                changed2 = true;
+            } else if constexpr (cas_total2) {
+                changed2 = atomic_total2_.apply(apply2_, d2);
+                cur2 = atomic_total2_.load();
+            } else if constexpr (apply2_is_default_add()) {
                 cur2 += d2;
                 changed2 = true;
             } else {
@@ -1028,16 +4268,68 @@ private:
             }
         }
 
-        if (changed1 || changed2) {
+        if (!publish_totals) {
+            // Coalesced: leave the published copies for a later publication or flush().
+            if constexpr (deferrable_total1) changed1 = arg_changed1 = qs_changed1 = false;
+            if constexpr (deferrable_total2) changed2 = arg_changed2 = qs_changed2 = false;
+        }
+
+        [[maybe_unused]] bool extras_changed = false;
+        [[maybe_unused]] std::tuple<std::optional<typename ExtraAggregates::total_type>...> extras;
+        if constexpr (sizeof...(ExtraAggregates) > 0) {
+            update_extras(old_elems, new_elems, id);
+            if (publish_totals) {
+                extras = changed_extras();
+                extras_changed = std::apply([](const auto &...c) { return (bool(c) || ...); }, extras);
+            }
+        }
+
+        [[maybe_unused]] std::pair<group_ptr, group_ptr> touched;
+        if constexpr (grouped) {
+            touched = update_groups(d1, d2, old1, new1, old2, new2, id, old_elems, new_elems);
+            if (!publish_totals) touched = {};
+        }
+
+        [[maybe_unused]] bool flows = false;
+        if constexpr (flow_total1 || flow_total2) flows = flows_active();
+
+        if (changed1 || changed2 || arg_changed1 || arg_changed2 || qs_changed1 || qs_changed2 || extras_changed ||
+            touched.first || touched.second || flows) {
             reaction::batchExecute([&]{
                 if (changed1) total1_.value(cur1);
                 if (changed2) total2_.value(cur2);
+                if constexpr (detail::is_extremum_mode(Total1Mode)) {
+                    if (arg_changed1) argtotal1_.value(arg1);
+                }
+                if constexpr (detail::is_extremum_mode(Total2Mode)) {
+                    if (arg_changed2) argtotal2_.value(arg2);
+                }
+                if constexpr (Total1Mode == AggMode::Quantile) {
+                    if (qs_changed1) quantiles1_.value(std::move(qs1));
+                }
+                if constexpr (Total2Mode == AggMode::Quantile) {
+                    if (qs_changed2) quantiles2_.value(std::move(qs2));
+                }
+                if constexpr (sizeof...(ExtraAggregates) > 0) write_extras(extras);
+                if constexpr (grouped) {
+                    if (touched.first) touched.first->publish();
+                    if (touched.second) touched.second->publish();
+                }
+                if constexpr (flow_total1 || flow_total2) {
+                    if (flows) publish_flows();
+                }
             });
         }
     }
 
-    void apply_total1(const delta1_type &d) {
-        if constexpr (apply1_is_default_add()) {
+    void apply_total1(const delta1_type &d, bool publish = true) {
+        if constexpr (atomic_total1) {
+            atomic_total1_.add(d);
+            if (publish) total1_publisher_.publish([this] { return load_total1(); }, total1_);
+        } else if constexpr (cas_total1) {
+            if (atomic_total1_.apply(apply1_, d) && publish)
+                total1_publisher_.publish([this] { return load_total1(); }, total1_);
+        } else if constexpr (apply1_is_default_add()) {
             total1_ += d;
         } else {
             if constexpr (RequireCoarseLock) {
@@ -1053,8 +4345,14 @@ private:
         }
     }
 
-    void apply_total2(const delta2_type &d) {
-        if constexpr (apply2_is_default_add()) {
+    void apply_total2(const delta2_type &d, bool publish = true) {
+        if constexpr (atomic_total2) {
+            atomic_total2_.add(d);
+            if (publish) total2_publisher_.publish([this] { return load_total2(); }, total2_);
+        } else if constexpr (cas_total2) {
+            if (atomic_total2_.apply(apply2_, d) && publish)
+                total2_publisher_.publish([this] { return load_total2(); }, total2_);
+        } else if constexpr (apply2_is_default_add()) {
             total2_ += d;
         } else {
             if constexpr (RequireCoarseLock) {
@@ -1076,10 +4374,13 @@ private:
     
     // push helper
     [[nodiscard]] id_type push_one(elem1_type e1, elem2_type e2, typename ElemRecord::key_storage_t key) {
+        RecomputeGate gate(*this);
         id_type id = nextId_.fetch_add(1, std::memory_order_relaxed);
         typename ElemRecord::key_storage_t key_copy{};
+        [[maybe_unused]] typename ElemRecord::key_storage_t group_key{};
         if constexpr (!std::is_same_v<KeyT, std::monostate>) {
             key_copy = key;
+            if constexpr (grouped && detail::group_by_key_v<GroupFn, KeyT, Elem1T, Elem2T>) group_key = key;
         }
 
         reaction::Var<elem1_type> v1 = reaction::var(e1);
@@ -1098,19 +4399,26 @@ private:
             // Reject duplicate keys and roll back element insertion if key exists.
             auto ins = key_index_.insert(std::make_pair(std::move(key_copy), id));
             if (!ins.second) {
-                elems_.erase(id);
+                elems_.erase_if(id, [&](const auto &pair) {
+                    note_recompute_change(gate, pair.second, id);
+                    return true;
+                });
                 elem_count_.fetch_sub(1, std::memory_order_relaxed);
                 throw std::invalid_argument("push_back: duplicate key");
             }
         }
 
-        if constexpr (MaintainOrderedIndex) {
+        if constexpr (ordered_concurrent) {
+            // Index under the submap lock so a racing erase_by_key either sees the entry or wins.
+            std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+            elems_.modify_if(id, [&](auto &) { ordered_insert_locked(id, e1, e2); });
+        } else if constexpr (MaintainOrderedIndex) {
             // Phase 3: unique_lock for write operations
             std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
-            if (ordered_index_) {
-                ordered_index_->insert(id);
-            }
+            ordered_insert_locked(id, e1, e2);
         }
+        note_ordered_change();
+        if (gate.logging()) elems_.modify_if(id, [&](auto &pair) { note_recompute_insert(gate, pair.second, id); });
 
         delta1_type d1 = delta1_(e1, e2, elem1_type{}, elem2_type{});
         delta2_type d2 = delta2_(e1, e2, elem1_type{}, elem2_type{});
@@ -1122,11 +4430,15 @@ private:
 
         {
             // Serialize aggregate/index transitions with reactive updates and erase.
-            std::lock_guard<std::recursive_mutex> element_guard(element_mtx_);
+            std::unique_lock<std::recursive_mutex> element_guard(element_mtx_, std::defer_lock);
+            if constexpr (!atomic_totals) element_guard.lock();
             apply_pair(d1, d2,
                        /*old1*/ false, nullptr, /*new1*/ bool(new_ext1), new_ext1 ? &*new_ext1 : nullptr,
-                       /*old2*/ false, nullptr, /*new2*/ bool(new_ext2), new_ext2 ? &*new_ext2 : nullptr);
+                       /*old2*/ false, nullptr, /*new2*/ bool(new_ext2), new_ext2 ? &*new_ext2 : nullptr, id,
+                       elem_view{}, elem_view{&e1, &e2, &group_key});
         }
+        // The monitor below takes its own gate for every update, including the initial run.
+        gate.release();
 
         // Get stable pointers to the Vars (node-based map guarantees pointer stability)
         reaction::Var<elem1_type> *var1_ptr = nullptr;
@@ -1141,14 +4453,32 @@ private:
         reaction::Var<elem1_type> &var1_ref = *var1_ptr;
         reaction::Var<elem2_type> &var2_ref = *var2_ptr;
 
+        monitors_.insert(std::make_pair(id, make_element_monitor(id, var1_ref, var2_ref)));
+
+        maybe_publish_ordered_snapshot();
+        return id;
+    }
+
+    // Reaction monitor that applies an element's Var updates to the aggregates. With
+    // skip_initial_run, the run made when the action is created is skipped if it only repeats the
+    // values already recorded (the bulk path has applied them); only the first run is checked.
+    reaction::Action<> make_element_monitor(id_type id, reaction::Var<elem1_type> &var1_ref,
+                                            reaction::Var<elem2_type> &var2_ref, bool skip_initial_run = false) {
         auto delta1_copy = delta1_;
         auto delta2_copy = delta2_;
         auto extract1_copy = extract1_;
         auto extract2_copy = extract2_;
+        std::shared_ptr<std::atomic<bool>> initial;
+        if constexpr (std::equality_comparable<elem1_type> && std::equality_comparable<elem2_type>) {
+            if (skip_initial_run) initial = std::make_shared<std::atomic<bool>>(true);
+        }
 
-        monitors_.insert(std::make_pair(id, reaction::action(
-            [this, id, delta1_copy, delta2_copy, extract1_copy, extract2_copy](elem1_type new1, elem2_type new2) {
-                std::lock_guard<std::recursive_mutex> element_guard(this->element_mtx_);
+        return reaction::action(
+            [this, id, delta1_copy, delta2_copy, extract1_copy, extract2_copy, initial](elem1_type new1, elem2_type new2) {
+                if (initial && initial->exchange(false) && same_as_recorded(id, new1, new2)) return;
+                RecomputeGate gate(*this);
+                std::unique_lock<std::recursive_mutex> element_guard(this->element_mtx_, std::defer_lock);
+                if constexpr (!parallel_element_updates) element_guard.lock();
                 (void)extract1_copy;
                 (void)extract2_copy;
                 elem1_type ne1 = static_cast<elem1_type>(new1);
@@ -1156,6 +4486,7 @@ private:
 
                 elem1_type old_e1{};
                 elem2_type old_e2{};
+                [[maybe_unused]] KeyT elem_key{};
                 delta1_type dd1{};
                 delta2_type dd2{};
                 std::optional<total1_type> old_ext1, new_ext1;
@@ -1165,6 +4496,7 @@ private:
                 auto compute_change = [&](const ElemRecord &r) {
                     old_e1 = r.lastElem1;
                     old_e2 = r.lastElem2;
+                    if constexpr (grouped && detail::group_by_key_v<GroupFn, KeyT, Elem1T, Elem2T>) elem_key = r.key;
                     dd1 = delta1_copy(ne1, ne2, old_e1, old_e2);
                     dd2 = delta2_copy(ne1, ne2, old_e1, old_e2);
                     if constexpr (Total1Mode != AggMode::Add) {
@@ -1178,28 +4510,52 @@ private:
                     found = true;
                 };
 
-                if constexpr (MaintainOrderedIndex) {
+                if constexpr (ordered_concurrent) {
+                    // Capture, refresh lastElem and move the index entry under the submap lock:
+                    // updates of one id stay ordered while different ids relink in parallel.
+                    std::shared_lock<std::shared_mutex> lock(this->ordered_mtx_);
+                    elems_.modify_if(id, [&](auto &pair) {
+                        compute_change(pair.second);
+                        note_recompute_change(gate, pair.second, id, &ne1, &ne2);
+                        pair.second.lastElem1 = ne1;
+                        pair.second.lastElem2 = ne2;
+                        ordered_replace_locked(id, old_e1, old_e2, ne1, ne2);
+                    });
+                    if (!found) return;
+                } else if constexpr (MaintainOrderedIndex) {
                     // Remove with the old comparator-visible values, mutate, then reinsert.
                     std::unique_lock<std::shared_mutex> lock(this->ordered_mtx_);
                     elems_.if_contains(id, [&](const auto &pair) { compute_change(pair.second); });
                     if (!found) return;
 
-                    bool equivalent = (!cmp_(old_e1, old_e2, ne1, ne2) &&
-                                       !cmp_(ne1, ne2, old_e1, old_e2));
-                    if (!equivalent && ordered_index_) {
-                        ordered_index_->erase(id);
-                    }
-                    elems_.modify_if(id, [&](auto &pair) {
-                        pair.second.lastElem1 = ne1;
-                        pair.second.lastElem2 = ne2;
-                    });
-                    if (!equivalent && ordered_index_) {
-                        ordered_index_->insert(id);
+                    if constexpr (ordered_caches_keys) {
+                        // Cached keys: relink the existing node with the new key (no allocation).
+                        elems_.modify_if(id, [&](auto &pair) {
+                            note_recompute_change(gate, pair.second, id, &ne1, &ne2);
+                            pair.second.lastElem1 = ne1;
+                            pair.second.lastElem2 = ne2;
+                        });
+                        ordered_replace_locked(id, old_e1, old_e2, ne1, ne2);
+                    } else {
+                        bool equivalent = (!cmp_(old_e1, old_e2, ne1, ne2) &&
+                                           !cmp_(ne1, ne2, old_e1, old_e2));
+                        if (!equivalent && ordered_index_) {
+                            ordered_index_->erase(id);
+                        }
+                        elems_.modify_if(id, [&](auto &pair) {
+                            note_recompute_change(gate, pair.second, id, &ne1, &ne2);
+                            pair.second.lastElem1 = ne1;
+                            pair.second.lastElem2 = ne2;
+                        });
+                        if (!equivalent && ordered_index_) {
+                            ordered_index_->insert(id);
+                        }
                     }
                 } else {
                     elems_.modify_if(id, [&](auto &pair) {
                         compute_change(pair.second);
                         if (found) {
+                            note_recompute_change(gate, pair.second, id, &ne1, &ne2);
                             pair.second.lastElem1 = ne1;
                             pair.second.lastElem2 = ne2;
                         }
@@ -1207,20 +4563,304 @@ private:
                     if (!found) return;
                 }
 
+                note_ordered_change();
+                if constexpr (!atomic_totals) {
+                    if (!element_guard.owns_lock()) element_guard.lock();
+                }
                 apply_pair(dd1, dd2,
                            /*old1*/ bool(old_ext1), old_ext1 ? &*old_ext1 : nullptr,
                            /*new1*/ bool(new_ext1), new_ext1 ? &*new_ext1 : nullptr,
                            /*old2*/ bool(old_ext2), old_ext2 ? &*old_ext2 : nullptr,
-                           /*new2*/ bool(new_ext2), new_ext2 ? &*new_ext2 : nullptr);
+                           /*new2*/ bool(new_ext2), new_ext2 ? &*new_ext2 : nullptr, id,
+                           elem_view{&old_e1, &old_e2, &elem_key}, elem_view{&ne1, &ne2, &elem_key});
+                if (element_guard.owns_lock()) element_guard.unlock();
+                maybe_publish_ordered_snapshot();
             },
             var1_ref, var2_ref
-        )));
+        );
+    }
 
-        return id;
+    bool same_as_recorded(id_type id, const elem1_type &e1, const elem2_type &e2) const {
+        if constexpr (std::equality_comparable<elem1_type> && std::equality_comparable<elem2_type>) {
+            bool same = false;
+            elems_.if_contains(id, [&](const auto &pair) {
+                same = pair.second.lastElem1 == e1 && pair.second.lastElem2 == e2;
+            });
+            return same;
+        } else {
+            (void)id; (void)e1; (void)e2;
+            return false;
+        }
     }
 
-    [[nodiscard]] id_type push_one_no_batch(const elem1_type &e1, const elem2_type &e2, typename ElemRecord::key_storage_t key) {
-        return push_one(e1, e2, std::move(key));
+    // Bulk insertion behind the batch push_back. Records for ids first_id.. are grouped by submap
+    // and built under one lock per submap; keys are claimed once every record exists.
+    // Add totals applied with DefaultApplyAdd receive the sum of the push deltas and extractor
+    // trackers take every value, then a single apply_pair publishes; grouped collections and custom
+    // apply functors (whose application need not fold) apply per element instead.
+    void push_bulk(const std::vector<std::pair<elem1_type, elem2_type>> &vals, const std::vector<key_type> *keys) {
+        using key_storage_t = typename ElemRecord::key_storage_t;
+        RecomputeGate gate(*this);
+        const std::size_t n = vals.size();
+        auto key_at = [&](std::size_t i) {
+            return (keys && i < keys->size()) ? key_storage_t((*keys)[i]) : key_storage_t{};
+        };
+        const id_type first_id = nextId_.fetch_add(n, std::memory_order_relaxed);
+
+        constexpr std::size_t min_rows_per_worker = 4096;
+        const std::size_t submaps = elems_.subcnt();
+        std::vector<std::vector<std::size_t>> buckets(submaps);
+        for (std::size_t i = 0; i < n; ++i) buckets[elems_.subidx(elems_.hash(first_id + i))].push_back(i);
+        const std::size_t workers =
+            std::min({detail::worker_count(0), submaps, std::max<std::size_t>(1, n / min_rows_per_worker)});
+        detail::run_parallel(workers, [&](std::size_t t) {
+            for (std::size_t sub = t; sub < submaps; sub += workers) {
+                if (buckets[sub].empty()) continue;
+                elems_.with_submap_m(sub, [&](auto &submap) {
+                    submap.reserve(submap.size() + buckets[sub].size());
+                    for (std::size_t i : buckets[sub]) {
+                        submap.emplace(first_id + i, ElemRecord(reaction::var(vals[i].first), reaction::var(vals[i].second),
+                                                                key_at(i)));
+                    }
+                });
+            }
+        });
+        elem_count_.fetch_add(n, std::memory_order_relaxed);
+
+        // Keys after records, as in push_one(): a key that resolves always finds its element. A
+        // conflict rolls back the keys claimed so far and every record of the batch.
+        if constexpr (has_keys) {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (key_index_.insert(std::make_pair(key_at(i), first_id + i)).second) continue;
+                for (std::size_t j = 0; j < i; ++j) {
+                    key_index_.erase_if(key_at(j), [&](const auto &pair) { return pair.second == first_id + j; });
+                }
+                std::size_t removed = 0;
+                for (std::size_t j = 0; j < n; ++j) {
+                    const bool erased = elems_.erase_if(first_id + j, [&](const auto &pair) {
+                        note_recompute_change(gate, pair.second, first_id + j);
+                        return true;
+                    });
+                    if (erased) ++removed;
+                }
+                elem_count_.fetch_sub(removed, std::memory_order_relaxed);
+                throw std::invalid_argument("push_back(batch): key already exists");
+            }
+        }
+
+        if (gate.logging()) {
+            for (std::size_t i = 0; i < n; ++i) {
+                elems_.modify_if(first_id + i, [&](auto &pair) { note_recompute_insert(gate, pair.second, first_id + i); });
+            }
+        }
+
+        if constexpr (ordered_concurrent) {
+            std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+            for (std::size_t i = 0; i < n; ++i) {
+                const id_type id = first_id + i;
+                elems_.modify_if(id, [&](auto &) { ordered_insert_locked(id, vals[i].first, vals[i].second); });
+            }
+        } else if constexpr (MaintainOrderedIndex) {
+            // Keys are already published, so an erase_by_key may have dropped a record before its
+            // entry got here; skip those rather than index an id without a record.
+            std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (elems_.contains(first_id + i)) ordered_insert_locked(first_id + i, vals[i].first, vals[i].second);
+            }
+        }
+        note_ordered_change(n);
+
+        {
+            std::unique_lock<std::recursive_mutex> element_guard(element_mtx_, std::defer_lock);
+            if constexpr (!atomic_totals) element_guard.lock();
+            apply_bulk(vals, first_id, key_at);
+        }
+        gate.release();
+
+        // Monitors last: each one's creation run repeats the values just applied and is skipped.
+        // monitors_ hashes ids like elems_, so each bucket also fills a single monitors_ submap.
+        // The Var handles are copied under the submap lock, so a record erased meanwhile cannot
+        // leave the monitor on a destroyed Var.
+        detail::run_parallel(workers, [&](std::size_t t) {
+            std::vector<std::tuple<id_type, reaction::Var<elem1_type>, reaction::Var<elem2_type>>> vars;
+            std::vector<std::pair<id_type, reaction::Action<>>> made;
+            std::vector<id_type> gone;
+            for (std::size_t sub = t; sub < submaps; sub += workers) {
+                if (buckets[sub].empty()) continue;
+                vars.clear();
+                made.clear();
+                gone.clear();
+                elems_.with_submap_m(sub, [&](auto &submap) {
+                    for (std::size_t i : buckets[sub]) {
+                        auto it = submap.find(first_id + i);
+                        if (it == submap.end()) continue;  // already erased by a racing writer
+                        vars.emplace_back(first_id + i, it->second.elem1Var, it->second.elem2Var);
+                    }
+                });
+                for (auto &[id, var1, var2] : vars) {
+                    made.emplace_back(id, make_element_monitor(id, var1, var2, /*skip_initial_run*/ true));
+                }
+                monitors_.with_submap_m(sub, [&](auto &submap) {
+                    submap.reserve(submap.size() + made.size());
+                    for (auto &monitor : made) submap.insert(std::move(monitor));
+                });
+                // An erase that dropped its record before the inserts above found no monitor to
+                // close; close those here. Later erases find and close the monitor themselves.
+                elems_.with_submap_m(sub, [&](auto &submap) {
+                    for (const auto &entry : vars) {
+                        if (!submap.contains(std::get<0>(entry))) gone.push_back(std::get<0>(entry));
+                    }
+                });
+                for (id_type id : gone) monitors_.erase_if(id, [](auto &pair) { pair.second.close(); return true; });
+            }
+        });
+        maybe_publish_ordered_snapshot();
+    }
+
+    // Whether a batch's aggregate changes can be summed into one apply_pair.
+    static constexpr bool bulk_apply_folds() {
+        constexpr bool fold1 = Total1Mode != AggMode::Add || (apply1_is_default_add() && std::is_same_v<delta1_type, total1_type>);
+        constexpr bool fold2 = Total2Mode != AggMode::Add || (apply2_is_default_add() && std::is_same_v<delta2_type, total2_type>);
+        return fold1 && fold2 && !grouped;
+    }
+
+    template <typename KeyAt>
+    void apply_bulk(const std::vector<std::pair<elem1_type, elem2_type>> &vals, id_type first_id, const KeyAt &key_at) {
+        if constexpr (bulk_apply_folds()) {
+            delta1_type sum1{};
+            delta2_type sum2{};
+            for (std::size_t i = 0; i < vals.size(); ++i) {
+                const id_type id = first_id + i;
+                const auto &[e1, e2] = vals[i];
+                if constexpr (Total1Mode == AggMode::Add) sum1 = detail::wrapping_add(sum1, delta1_(e1, e2, elem1_type{}, elem2_type{}));
+                else insert_index1(extract1_(e1, e2), id);
+                if constexpr (Total2Mode == AggMode::Add) sum2 = detail::wrapping_add(sum2, delta2_(e1, e2, elem1_type{}, elem2_type{}));
+                else insert_index2(extract2_(e1, e2), id);
+                if constexpr (sizeof...(ExtraAggregates) > 0) update_extras(elem_view{}, elem_view{&e1, &e2, nullptr}, id);
+            }
+            (void)key_at;
+            apply_pair(sum1, sum2);
+        } else {
+            for (std::size_t i = 0; i < vals.size(); ++i) {
+                const auto &[e1, e2] = vals[i];
+                [[maybe_unused]] typename ElemRecord::key_storage_t group_key{};
+                if constexpr (grouped && detail::group_by_key_v<GroupFn, KeyT, Elem1T, Elem2T>) group_key = key_at(i);
+                std::optional<total1_type> new_ext1;
+                std::optional<total2_type> new_ext2;
+                if constexpr (Total1Mode != AggMode::Add) new_ext1 = extract1_(e1, e2);
+                if constexpr (Total2Mode != AggMode::Add) new_ext2 = extract2_(e1, e2);
+                apply_pair(delta1_(e1, e2, elem1_type{}, elem2_type{}), delta2_(e1, e2, elem1_type{}, elem2_type{}),
+                           /*old1*/ false, nullptr, /*new1*/ bool(new_ext1), new_ext1 ? &*new_ext1 : nullptr,
+                           /*old2*/ false, nullptr, /*new2*/ bool(new_ext2), new_ext2 ? &*new_ext2 : nullptr,
+                           first_id + i, elem_view{}, elem_view{&e1, &e2, &group_key});
+            }
+        }
+    }
+
+    // Last state of a removed element, enough to retract it from the aggregates.
+    struct ErasedRecord {
+        id_type id;
+        elem1_type last1;
+        elem2_type last2;
+        typename ElemRecord::key_storage_t key;
+    };
+
+    // Runs f under the ordered lock an erase needs: shared for the skip list (its entries are
+    // removed under the record's submap lock), exclusive for the tree backends.
+    template <typename F>
+    void with_ordered_write_lock(F &&f) {
+        if constexpr (ordered_concurrent) {
+            std::shared_lock<std::shared_mutex> lock(ordered_mtx_);
+            f();
+        } else if constexpr (MaintainOrderedIndex) {
+            std::unique_lock<std::shared_mutex> lock(ordered_mtx_);
+            f();
+        } else {
+            f();
+        }
+    }
+
+    // Removes id from elems_ and the ordered index; the caller holds the lock taken by
+    // with_ordered_write_lock(). Empty when the id is unknown (or a racing erase won).
+    std::optional<ErasedRecord> take_record_locked(id_type id, RecomputeGate &gate) {
+        std::optional<ErasedRecord> erased;
+        auto snapshot = [&](const auto &pair) {
+            erased = ErasedRecord{id, pair.second.lastElem1, pair.second.lastElem2, {}};
+            if constexpr (has_keys) erased->key = pair.second.key;
+        };
+
+        if constexpr (ordered_concurrent) {
+            // Snapshot, unindex and remove under the submap lock: a racing update of the same id
+            // either lands first (and its entry is erased here) or finds nothing.
+            elems_.erase_if(id, [&](const auto &pair) {
+                snapshot(pair);
+                note_recompute_change(gate, pair.second, id);
+                ordered_erase_locked(id, erased->last1, erased->last2);
+                return true;
+            });
+        } else if constexpr (MaintainOrderedIndex) {
+            // Keep comparator-visible element state stable until the id leaves the tree, and drop
+            // the record in the same section so a rebuild snapshot never sees it without its entry.
+            elems_.if_contains(id, snapshot);
+            if (erased) {
+                if constexpr (ordered_caches_keys) {
+                    // Record first: a top-K refill scan must not pick the departing element.
+                    elems_.erase_if(id, [&](const auto &pair) {
+                        note_recompute_change(gate, pair.second, id);
+                        return true;
+                    });
+                    if (ordered_index_) ordered_erase_locked(id, erased->last1, erased->last2);
+                } else {
+                    // Id trees still need the record to compare while unlinking it.
+                    if (ordered_index_) ordered_erase_locked(id, erased->last1, erased->last2);
+                    elems_.erase_if(id, [&](const auto &pair) {
+                        note_recompute_change(gate, pair.second, id);
+                        return true;
+                    });
+                }
+            }
+        } else {
+            // Snapshot and remove in one submap critical section, so a racing update of the same id
+            // either lands first or finds nothing (element_mtx_ no longer orders them).
+            elems_.erase_if(id, [&](const auto &pair) {
+                snapshot(pair);
+                note_recompute_change(gate, pair.second, id);
+                return true;
+            });
+        }
+        return erased;
+    }
+
+    void apply_erased(const ErasedRecord &rec) {
+        std::optional<total1_type> old_ext1;
+        std::optional<total2_type> old_ext2;
+        if constexpr (Total1Mode != AggMode::Add) old_ext1 = extract1_(rec.last1, rec.last2);
+        if constexpr (Total2Mode != AggMode::Add) old_ext2 = extract2_(rec.last1, rec.last2);
+        apply_pair(delta1_(elem1_type{}, elem2_type{}, rec.last1, rec.last2),
+                   delta2_(elem1_type{}, elem2_type{}, rec.last1, rec.last2),
+                   /*have_old1*/ bool(old_ext1), old_ext1 ? &*old_ext1 : nullptr,
+                   /*have_new1*/ false, nullptr,
+                   /*have_old2*/ bool(old_ext2), old_ext2 ? &*old_ext2 : nullptr,
+                   /*have_new2*/ false, nullptr, rec.id, elem_view{&rec.last1, &rec.last2, &rec.key});
+    }
+
+    // Retracts a batch of removed elements: folded like apply_bulk() into one apply_pair where
+    // the aggregates allow it, otherwise one apply_pair per element.
+    void apply_erase_bulk(const std::vector<ErasedRecord> &erased) {
+        if constexpr (bulk_apply_folds()) {
+            delta1_type sum1{};
+            delta2_type sum2{};
+            for (const auto &rec : erased) {
+                if constexpr (Total1Mode == AggMode::Add) sum1 = detail::wrapping_add(sum1, delta1_(elem1_type{}, elem2_type{}, rec.last1, rec.last2));
+                else erase_one_index1(extract1_(rec.last1, rec.last2), rec.id);
+                if constexpr (Total2Mode == AggMode::Add) sum2 = detail::wrapping_add(sum2, delta2_(elem1_type{}, elem2_type{}, rec.last1, rec.last2));
+                else erase_one_index2(extract2_(rec.last1, rec.last2), rec.id);
+                if constexpr (sizeof...(ExtraAggregates) > 0) update_extras(elem_view{&rec.last1, &rec.last2, nullptr}, elem_view{}, rec.id);
+            }
+            apply_pair(sum1, sum2);
+        } else {
+            for (const auto &rec : erased) apply_erased(rec);
+        }
     }
 
     //==============================================================================
@@ -1231,6 +4871,38 @@ private:
     reaction::Var<total1_type> total1_;
     reaction::Var<total2_type> total2_;
 
+    // Min/Max totals: id of an element holding the extremum (0 when empty), written only on change.
+    std::conditional_t<detail::is_extremum_mode(Total1Mode), reaction::Var<id_type>, std::monostate> argtotal1_;
+    std::conditional_t<detail::is_extremum_mode(Total2Mode), reaction::Var<id_type>, std::monostate> argtotal2_;
+    // Quantile totals: the configured quantiles, in configuration order, written only on change.
+    std::conditional_t<Total1Mode == AggMode::Quantile, reaction::Var<std::vector<total1_type>>, std::monostate>
+        quantiles1_;
+    std::conditional_t<Total2Mode == AggMode::Quantile, reaction::Var<std::vector<total2_type>>, std::monostate>
+        quantiles2_;
+
+    // Authoritative Add totals when atomic_total*/cas_total*; total1_/total2_ are their published copies.
+    // CAS-applied totals always use a single atomic: clamping functors do not fold across shards.
+    std::conditional_t<atomic_total1, typename detail::total_accumulator<TotalAccumulator, total1_type>::type,
+                       std::conditional_t<cas_total1, detail::AtomicTotal<total1_type>, std::monostate>>
+        atomic_total1_{};
+    std::conditional_t<atomic_total2, typename detail::total_accumulator<TotalAccumulator, total2_type>::type,
+                       std::conditional_t<cas_total2, detail::AtomicTotal<total2_type>, std::monostate>>
+        atomic_total2_{};
+    detail::TotalPublisher total1_publisher_;
+    detail::TotalPublisher total2_publisher_;
+    detail::TotalPublisher argtotal1_publisher_;
+    detail::TotalPublisher argtotal2_publisher_;
+    detail::TotalPublisher quantiles1_publisher_;
+    detail::TotalPublisher quantiles2_publisher_;
+    // One state per extra Aggregate descriptor.
+    std::tuple<ExtraAggregateState<ExtraAggregates>...> extras_;
+    // Sliding-window / decayed flows of Add totals (flow_total1 / flow_total2 only).
+    std::conditional_t<flow_total1, FlowTotals<total1_type>, std::monostate> flows1_{};
+    std::conditional_t<flow_total2, FlowTotals<total2_type>, std::monostate> flows2_{};
+    // Per-group totals (grouped only); groups stay until prune_empty_groups().
+    GroupFn group_fn_{};
+    std::conditional_t<grouped, concurrent_map_t<group_type, group_ptr>, std::monostate> groups_{};
+
     Delta1Fn delta1_;
     Apply1Fn apply1_;
     Delta2Fn delta2_;
@@ -1239,8 +4911,8 @@ private:
     Extract1Fn extract1_;
     Extract2Fn extract2_;
 
-    // runtime comparator (stores any callable convertible to compare_fn_t)
-    compare_fn_t cmp_;
+    // comparator: compare_fn_t (runtime-replaceable) or CompareFn when DynamicCompare == false
+    compare_holder_type cmp_;
 
     // Underlying storage - parallel-hashmap concurrent node maps
     elem_map_type elems_;
@@ -1251,8 +4923,40 @@ private:
     std::optional<ordered_set_type> ordered_index_;
     mutable std::shared_mutex ordered_mtx_;  // Reader-writer lock
 
-    std::map<total1_type, std::size_t> idx1_;
-    std::map<total2_type, std::size_t> idx2_;
+    // Off-lock rebuild support: writer changes logged while a cached-key rebuild is in flight
+    // (guarded by ordered_mtx_); rebuild_mtx_ serializes rebuilds.
+    struct OrderedChange {
+        std::optional<OrderedEntry> before;
+        std::optional<OrderedEntry> after;
+    };
+    std::optional<std::vector<OrderedChange>> rebuild_log_;
+    std::mutex rebuild_mtx_;
+    OrderedRebuildStats last_rebuild_stats_{};
+
+    // Published ordered snapshots: readers load snapshot_ atomically; snapshot_build_mtx_ keeps a
+    // single publisher at a time.
+    mutable std::atomic<ordered_snapshot_ptr> snapshot_{std::make_shared<const OrderedSnapshot>()};
+    mutable std::mutex snapshot_build_mtx_;
+    mutable std::uint64_t snapshot_version_ = 0;  // guarded by snapshot_build_mtx_
+    mutable std::atomic<bool> snapshots_enabled_{false};
+    mutable std::atomic<std::size_t> ordered_changes_{0};
+    mutable std::atomic<std::int64_t> snapshot_published_us_{0};
+    std::atomic<std::size_t> snapshot_max_changes_{1024};
+    std::atomic<std::int64_t> snapshot_max_age_us_{16000};
+
+    // PublicationPolicy of total1_/total2_ and the bookkeeping its EveryN/Interval modes need.
+    std::atomic<PublicationPolicy::Mode> publish_mode_{PublicationPolicy::Mode::Immediate};
+    std::atomic<std::size_t> publish_every_n_{1};
+    std::atomic<std::int64_t> publish_interval_us_{0};
+    std::atomic<std::size_t> publish_pending_{0};
+    std::atomic<std::int64_t> publish_last_us_{0};
+
+    // Extractor-driven totals not read off the ordered index: concurrent extremum (Min/Max) or the
+    // Count/Mean/Variance/Range tracker over extractor values; total1_/total2_ are published copies.
+    std::conditional_t<Total1Mode != AggMode::Add && !index_total1,
+                       typename detail::extract_aggregate<Total1Mode, total1_type, std::size_t>::type, std::monostate> idx1_{};
+    std::conditional_t<Total2Mode != AggMode::Add && !index_total2,
+                       typename detail::extract_aggregate<Total2Mode, total2_type, std::size_t>::type, std::monostate> idx2_{};
 
     std::mutex total1_mtx_;
     std::mutex total2_mtx_;
@@ -1261,9 +4965,28 @@ private:
     mutable std::mutex coarse_mtx_;
     bool coarse_lock_enabled_;
 
-    // Serializes per-element reactive updates and erase lifecycles.
+    // Serializes per-element reactive updates and erase lifecycles (only the aggregate application
+    // when parallel_element_updates, and nothing when atomic_totals as well).
     std::recursive_mutex element_mtx_;
 
+    // recompute_totals() support. Writers announce themselves in `inflight` while no recompute
+    // runs and hold swap_mtx shared while one does; changes to records the scan already counted
+    // are logged (under log_mtx) and replayed onto the fresh totals when they are swapped in.
+    struct RecomputeState {
+        struct alignas(64) InflightSlot {
+            std::atomic<std::size_t> writers{0};
+        };
+        std::array<InflightSlot, 16> inflight{};
+        std::array<std::atomic<bool>, elem_map_type::subcnt()> scanned{};
+        std::atomic<bool> active{false};
+        std::atomic<std::uint64_t> gen{0};
+        std::shared_mutex swap_mtx;
+        std::mutex mtx;  // one recompute at a time
+        std::mutex log_mtx;
+        std::vector<RecomputeChange> log;
+    };
+    std::conditional_t<recomputable_totals, RecomputeState, std::monostate> recompute_;
+
     key_index_map_type key_index_{};
 
     bool combined_atomic_;
@@ -218,6 +218,286 @@ void benchmark_with_and_without_coarse_lock() {
     }
 }
 
+template <bool DynamicCompare>
+using RebuildColl = ReactiveTwoFieldCollection<
+    double, long, long, double,
+    detail::DefaultDelta1<double, long, long>,
+    detail::DefaultApplyAdd<long>,
+    detail::DefaultDelta2<double, long, double>,
+    detail::DefaultApplyAdd<double>,
+    std::monostate,
+    AggMode::Add, AggMode::Add,
+    DefaultExtract1<double, long, long>,
+    DefaultExtract2<double, long, double>,
+    false, true, DefaultCompare<double, long>,
+    std::unordered_map,
+    CachedKeyOrderedIndex,
+    DynamicCompare
+>;
+
+template <bool DynamicCompare>
+long long time_rebuild_ms(int elements, int rounds) {
+    RebuildColl<DynamicCompare> c({}, {}, {}, {}, false, false);
+    for (int i = 0; i < elements; ++i) {
+        c.push_back(static_cast<double>((i * 7919) % elements), long(i));
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; ++r) c.rebuild_ordered_index();
+    auto end = std::chrono::high_resolution_clock::now();
+    assert(c.bottom_k(1).size() == 1);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+void benchmark_static_vs_dynamic_compare() {
+    std::cout << "\nBenchmarking: rebuild_ordered_index() with std::function vs inlined CompareFn...\n";
+
+    const int ELEMENTS = 20000;
+    const int ROUNDS = 5;
+    auto dynamic_ms = time_rebuild_ms<true>(ELEMENTS, ROUNDS);
+    auto static_ms = time_rebuild_ms<false>(ELEMENTS, ROUNDS);
+
+    std::cout << "  " << ROUNDS << " rebuilds of " << ELEMENTS << " elements\n";
+    std::cout << "  std::function comparator: " << dynamic_ms << " ms\n";
+    std::cout << "  CompareFn (DynamicCompare=false): " << static_ms << " ms\n";
+}
+
+void benchmark_parallel_rebuild() {
+    std::cout << "\nBenchmarking: parallel rebuild_ordered_index() phases...\n";
+
+    const int ELEMENTS = 200000;
+    RebuildColl<false> c({}, {}, {}, {}, false, false);
+    for (int i = 0; i < ELEMENTS; ++i) {
+        c.push_back(static_cast<double>((i * 7919) % ELEMENTS), long(i));
+    }
+    for (std::size_t threads : {std::size_t(1), std::size_t(0)}) {
+        auto stats = c.rebuild_ordered_index(threads);
+        std::cout << "  threads=" << stats.threads << ": snapshot " << stats.snapshot_time.count()
+                  << " us, sort " << stats.sort_time.count() << " us, build " << stats.build_time.count()
+                  << " us, swap (exclusive lock) " << stats.swap_time.count() << " us\n";
+        assert(stats.elements == static_cast<std::size_t>(ELEMENTS));
+    }
+}
+
+template <typename Policy>
+using PolicyColl = ReactiveTwoFieldCollection<
+    double, long, long, double,
+    detail::DefaultDelta1<double, long, long>,
+    detail::DefaultApplyAdd<long>,
+    detail::DefaultDelta2<double, long, double>,
+    detail::DefaultApplyAdd<double>,
+    std::monostate,
+    AggMode::Add, AggMode::Add,
+    DefaultExtract1<double, long, long>,
+    DefaultExtract2<double, long, double>,
+    false, true, DefaultCompare<double, long>,
+    std::unordered_map,
+    Policy
+>;
+
+template <typename Policy>
+long long time_parallel_reorders_ms(int writers, int updates_per_writer) {
+    PolicyColl<Policy> c({}, {}, {}, {}, false, false);
+    std::vector<size_t> ids;
+    for (int i = 0; i < 4096; ++i) ids.push_back(c.push_back(static_cast<double>(i), long(i)));
+
+    std::atomic<bool> stop{false};
+    std::thread reader([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            auto view = c.ordered();
+            for (auto it = view.begin(); it != view.end(); ++it) {
+            }
+        }
+    });
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < updates_per_writer; ++i) {
+                const auto idx = static_cast<size_t>(t + writers * (i % 512)) % ids.size();
+                c.elem1Var(ids[idx]).value(static_cast<double>((i * 7919 + t) % 4096));
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    stop.store(true, std::memory_order_relaxed);
+    reader.join();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+void benchmark_skip_list_vs_locked_index() {
+    std::cout << "\nBenchmarking: reactive reorders with a concurrent ordered() reader...\n";
+
+    const int UPDATES = 20000;
+    for (int writers : {1, 4, 16}) {
+        auto locked_ms = time_parallel_reorders_ms<CachedKeyOrderedIndex>(writers, UPDATES / writers);
+        auto skip_ms = time_parallel_reorders_ms<ConcurrentSkipListOrderedIndex>(writers, UPDATES / writers);
+        std::cout << "  " << writers << " writer(s): CachedKeyOrderedIndex " << locked_ms
+                  << " ms, ConcurrentSkipListOrderedIndex " << skip_ms << " ms\n";
+    }
+}
+
+template <typename Policy>
+long long time_single_writer_updates_ms(int elements, int updates) {
+    PolicyColl<Policy> c({}, {}, {}, {}, false, false);
+    std::vector<size_t> ids;
+    for (int i = 0; i < elements; ++i) ids.push_back(c.push_back(static_cast<double>(i % 1000), long(i)));
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < updates; ++i) {
+        const auto idx = static_cast<size_t>(i * 7919) % ids.size();
+        c.elem1Var(ids[idx]).value(static_cast<double>((i * 31) % 1000));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    assert(c.top_k(20).size() == 20);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+void benchmark_top_k_vs_full_index() {
+    std::cout << "\nBenchmarking: MaintainTopK<20> vs full cached-key index...\n";
+
+    const int ELEMENTS = 50000;
+    const int UPDATES = 200000;
+    auto full_ms = time_single_writer_updates_ms<CachedKeyOrderedIndex>(ELEMENTS, UPDATES);
+    auto top_ms = time_single_writer_updates_ms<MaintainTopK<20>>(ELEMENTS, UPDATES);
+    std::cout << "  " << UPDATES << " updates over " << ELEMENTS << " elements\n";
+    std::cout << "  CachedKeyOrderedIndex: " << full_ms << " ms\n";
+    std::cout << "  MaintainTopK<20>:      " << top_ms << " ms\n";
+}
+
+// Same arithmetic as DefaultApplyAdd, but not recognized as such: keeps the Var-backed total path.
+struct VarBackedAdd {
+    using DeltaType = long;
+    bool operator()(long &total, const long &d) const noexcept {
+        total = detail::wrapping_add(total, d);
+        return true;
+    }
+};
+
+template <typename Apply1Fn>
+double time_concurrent_total_updates_ms(int threads_n, int updates) {
+    using Coll = ReactiveTwoFieldCollection<
+        double, long, long, double,
+        detail::DefaultDelta1<double, long, long>, Apply1Fn>;
+    Coll c({}, {}, {}, {}, false, false);
+
+    std::vector<typename Coll::id_type> ids;
+    for (int t = 0; t < threads_n; ++t) ids.push_back(c.push_back(1.0, 0));
+
+    std::atomic<bool> done{false};
+    std::thread reader([&]() {
+        while (!done.load(std::memory_order_acquire)) {
+            volatile long t1 = c.total1();
+            (void)t1;
+        }
+    });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads_n; ++t) {
+        writers.emplace_back([&, t]() {
+            auto var = c.elem2Var(ids[static_cast<size_t>(t)]);
+            for (int i = 1; i <= updates; ++i) var.value(i);
+        });
+    }
+    for (auto &th : writers) th.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    assert(c.total1() == static_cast<long>(threads_n) * updates);
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void benchmark_atomic_vs_var_totals() {
+    std::cout << "\nBenchmarking: atomic Add totals vs Var-backed totals...\n";
+
+    const int NUM_THREADS = 4;
+    const int UPDATES = 50000;
+    auto var_ms = time_concurrent_total_updates_ms<VarBackedAdd>(NUM_THREADS, UPDATES);
+    auto atomic_ms = time_concurrent_total_updates_ms<detail::DefaultApplyAdd<long>>(NUM_THREADS, UPDATES);
+    std::cout << "  " << NUM_THREADS << " writers x " << UPDATES << " updates, one total1() poller\n";
+    std::cout << "  Var-backed total: " << var_ms << " ms\n";
+    std::cout << "  Atomic total:     " << atomic_ms << " ms\n";
+}
+
+template <typename Accumulator>
+using AccumulatorColl = ReactiveTwoFieldCollection<
+    double, long, long, double,
+    detail::DefaultDelta1<double, long, long>,
+    detail::DefaultApplyAdd<long>,
+    detail::DefaultDelta2<double, long, double>,
+    detail::DefaultApplyAdd<double>,
+    std::monostate,
+    AggMode::Add, AggMode::Add,
+    DefaultExtract1<double, long, long>,
+    DefaultExtract2<double, long, double>,
+    false, false, DefaultCompare<double, long>, std::unordered_map,
+    IdOrderedIndex, true, Accumulator
+>;
+
+template <typename Accumulator>
+double writer_updates_per_ms(int writers, int updates_per_writer) {
+    AccumulatorColl<Accumulator> c({}, {}, {}, {}, false, false);
+    std::vector<size_t> ids;
+    for (int t = 0; t < writers; ++t) ids.push_back(c.push_back(1.0, 0));
+
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&, t]() {
+            auto var = c.elem2Var(ids[static_cast<size_t>(t)]);
+            ready.fetch_add(1, std::memory_order_acq_rel);
+            while (ready.load(std::memory_order_acquire) != writers) std::this_thread::yield();
+            for (int i = 1; i <= updates_per_writer; ++i) var.value(i);
+        });
+    }
+    for (auto &th : threads) th.join();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    assert(c.total1() == static_cast<long>(writers) * updates_per_writer);
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    return static_cast<double>(writers) * updates_per_writer / ms;
+}
+
+void benchmark_sharded_accumulator_scaling() {
+    std::cout << "\nBenchmarking: AtomicAccumulator vs ShardedAccumulator<32> (1..32 writers)...\n";
+    std::cout << "  (" << std::thread::hardware_concurrency() << " hardware threads)\n";
+
+    const int UPDATES_PER_WRITER = 10000;
+    for (int writers : {1, 2, 4, 8, 16, 32}) {
+        auto atomic_rate = writer_updates_per_ms<AtomicAccumulator>(writers, UPDATES_PER_WRITER);
+        auto sharded_rate = writer_updates_per_ms<ShardedAccumulator<32>>(writers, UPDATES_PER_WRITER);
+        std::cout << "  " << writers << " writers: atomic " << atomic_rate << " updates/ms, sharded "
+                  << sharded_rate << " updates/ms\n";
+    }
+}
+
+void benchmark_bulk_push() {
+    std::cout << "\nBenchmarking: batch push_back vs per-row push_back...\n";
+
+    using Coll = AccumulatorColl<AtomicAccumulator>;
+    const std::size_t ROWS = 200000;
+    std::vector<std::pair<double, long>> rows;
+    rows.reserve(ROWS);
+    for (std::size_t i = 0; i < ROWS; ++i) rows.emplace_back(1.0, static_cast<long>(i % 1000));
+
+    Coll per_row({}, {}, {}, {}, false, false);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto &[e1, e2] : rows) (void)per_row.push_back(e1, e2);
+    auto per_row_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    Coll bulk({}, {}, {}, {}, false, false);
+    start = std::chrono::high_resolution_clock::now();
+    bulk.push_back(rows);
+    auto bulk_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    assert(bulk.size() == ROWS && bulk.total1() == per_row.total1());
+    std::cout << "  " << ROWS << " rows\n";
+    std::cout << "  Per-row push_back: " << per_row_ms << " ms\n";
+    std::cout << "  Batch push_back:   " << bulk_ms << " ms\n";
+}
+
 int main() {
     std::cout << "=== Lock-Free Optimization Tests ===\n\n";
     
@@ -225,6 +505,13 @@ int main() {
     test_size_and_empty();
     test_id_generation();
     benchmark_with_and_without_coarse_lock();
+    benchmark_static_vs_dynamic_compare();
+    benchmark_parallel_rebuild();
+    benchmark_skip_list_vs_locked_index();
+    benchmark_top_k_vs_full_index();
+    benchmark_atomic_vs_var_totals();
+    benchmark_sharded_accumulator_scaling();
+    benchmark_bulk_push();
     
     std::cout << "\n=== All tests passed! ===\n";
     return 0;